@@ -1,12 +1,32 @@
 #pragma once
 #include <string_view>
+#include "../../src/AsyncAsset.hpp"
 #include "../../src/Camera.hpp"
+#include "../../src/ClusteredMesh.hpp"
+#include "../../src/ComputeShader.hpp"
+#include "../../src/DrawBatch.hpp"
+#include "../../src/DynamicMesh.hpp"
 #include "../../src/EventsCallbacks.hpp"
+#include "../../src/InstanceBuffer.hpp"
+#include "../../src/LodMesh.hpp"
 #include "../../src/Mesh.hpp"
+#include "../../src/MeshArena.hpp"
+#include "../../src/MeshCache.hpp"
+#include "../../src/MeshData.hpp"
 #include "../../src/RenderTarget.hpp"
 #include "../../src/Shader.hpp"
+#include "../../src/ShaderVariants.hpp"
+#include "../../src/StateCache.hpp"
+#include "../../src/StorageBuffer.hpp"
 #include "../../src/Texture.hpp"
+#include "../../src/TextureSampler.hpp"
+#include "../../src/UniformBuffer.hpp"
+#include "../../src/VertexLayout.hpp"
+#include "../../src/load_async.hpp"
+#include "../../src/load_obj.hpp"
 #include "../../src/make_absolute_path.hpp"
+#include "../../src/optimize_mesh.hpp"
+#include "../../src/simplify_mesh.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 #include "tiny_obj_loader.h"
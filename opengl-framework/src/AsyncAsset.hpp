@@ -0,0 +1,45 @@
+#pragma once
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <optional>
+
+namespace gl {
+
+namespace internal {
+template<typename T>
+struct AsyncAssetState {
+    std::optional<T>   value{};
+    std::exception_ptr error{};
+};
+} // namespace internal
+
+/// Handle to an asset that is being loaded in the background.
+/// It becomes ready during a call to gl::window_is_open(), e.g. once the file has been read and decoded on a worker thread, and then uploaded to the GPU.
+template<typename T>
+class AsyncAsset {
+public:
+    explicit AsyncAsset(std::shared_ptr<internal::AsyncAssetState<T>> state)
+        : _state{std::move(state)}
+    {}
+
+    /// Returns true once the asset is usable, or once its loading has failed.
+    auto is_ready() const -> bool { return _state->value.has_value() || _state->error; }
+
+    /// You must check is_ready() first. If the loading failed, this rethrows the error that occurred.
+    auto get() const -> T const&
+    {
+        assert(is_ready() && "The asset is not ready yet. Check is_ready() before calling get().");
+        if (_state->error)
+            std::rethrow_exception(_state->error);
+        return *_state->value;
+    }
+
+    /// Returns nullptr while the asset is not ready (or if its loading failed).
+    auto get_if_ready() const -> T const* { return _state->value.has_value() ? &*_state->value : nullptr; }
+
+private:
+    std::shared_ptr<internal::AsyncAssetState<T>> _state;
+};
+
+} // namespace gl
@@ -0,0 +1,408 @@
+#include "BinaryMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include "hash.hpp"
+
+namespace gl::internal {
+
+namespace {
+
+// Must be incremented every time the format changes, or the AnyVertexAttribute variant changes (because we store the index of the alternatives).
+constexpr uint32_t format_version = 4;
+constexpr auto     magic          = std::array<char, 4>{'G', 'L', 'M', 'B'};
+
+struct Header {
+    std::array<char, 4>  magic{};
+    uint32_t             version{};
+    BinaryMesh_FileStamp obj{};
+    uint64_t             options_hash{};
+    uint32_t             material_files_count{};
+    uint32_t             material_files_size{}; // In bytes, they are stored right after the header
+    uint32_t             attributes_count{};
+    uint32_t             vertex_stride{};    // In bytes
+    uint64_t             vertex_data_size{}; // In bytes
+    uint64_t             indices_count{};
+    std::array<float, 3> bounds_min{};
+    std::array<float, 3> bounds_max{};
+    uint32_t             submeshes_count{}; // They are stored at the end of the file, after the indices
+    uint32_t             padding{};
+};
+
+struct Attribute {
+    int32_t  index{}; // Location in the shader
+    uint32_t kind{};  // Index of the alternative in AnyVertexAttribute
+};
+
+static_assert(sizeof(Header) % 8 == 0 && sizeof(Attribute) == 8, "So that the vertex data is properly aligned");
+
+auto make_attribute(Attribute const& attribute) -> std::optional<AnyVertexAttribute>
+{
+    static constexpr auto factories = []<size_t... I>(std::index_sequence<I...>) {
+        return std::array{+[](int index) -> AnyVertexAttribute { return std::variant_alternative_t<I, AnyVertexAttribute>{index}; }...};
+    }(std::make_index_sequence<std::variant_size_v<AnyVertexAttribute>>{});
+
+    if (attribute.kind >= factories.size())
+        return std::nullopt;
+    return factories[attribute.kind](attribute.index);
+}
+
+/// Submeshes contain strings, so they are written one field after the other instead of as a single struct
+void write_submesh(std::ofstream& ofs, Submesh const& submesh)
+{
+    auto const write_bytes = [&](void const* ptr, size_t size) {
+        ofs.write(static_cast<char const*>(ptr), static_cast<std::streamsize>(size));
+    };
+    auto const write_string = [&](std::string const& str) {
+        auto const size = static_cast<uint32_t>(str.size());
+        write_bytes(&size, sizeof(size));
+        write_bytes(str.data(), str.size());
+    };
+    write_bytes(&submesh.range, sizeof(submesh.range));
+    write_bytes(&submesh.material.diffuse_color, sizeof(submesh.material.diffuse_color));
+    write_string(submesh.material.name);
+    write_string(submesh.material.diffuse_texture.string());
+}
+
+/// Returns nullopt if there aren't enough bytes left
+auto read_submesh(std::span<std::byte const>& bytes) -> std::optional<Submesh>
+{
+    auto const read_bytes = [&](void* ptr, size_t size) {
+        if (bytes.size() < size)
+            return false;
+        std::memcpy(ptr, bytes.data(), size);
+        bytes = bytes.subspan(size);
+        return true;
+    };
+    auto const read_string = [&](std::string& str) {
+        auto size = uint32_t{};
+        if (!read_bytes(&size, sizeof(size)) || bytes.size() < size)
+            return false;
+        str.assign(reinterpret_cast<char const*>(bytes.data()), size); // NOLINT(*reinterpret-cast)
+        bytes = bytes.subspan(size);
+        return true;
+    };
+
+    auto submesh      = Submesh{};
+    auto texture_path = std::string{};
+    if (!read_bytes(&submesh.range, sizeof(submesh.range))
+        || !read_bytes(&submesh.material.diffuse_color, sizeof(submesh.material.diffuse_color))
+        || !read_string(submesh.material.name)
+        || !read_string(texture_path))
+        return std::nullopt;
+    submesh.material.diffuse_texture = texture_path;
+    return submesh;
+}
+
+auto hash_file_content(std::filesystem::path const& path) -> uint64_t
+{
+    auto       ifs     = std::ifstream{path, std::ios::binary};
+    auto const content = std::vector<char>{std::istreambuf_iterator<char>{ifs}, {}};
+    return hash_bytes(std::as_bytes(std::span{content}));
+}
+
+auto file_stamp(std::filesystem::path const& path, bool compute_content_hash) -> BinaryMesh_FileStamp
+{
+    auto error = std::error_code{};
+    if (!std::filesystem::exists(path, error))
+        return {};
+    return BinaryMesh_FileStamp{
+        .content_hash    = compute_content_hash ? hash_file_content(path) : 0,
+        .size_in_bytes   = static_cast<uint64_t>(std::filesystem::file_size(path)),
+        .last_write_time = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count()),
+    };
+}
+
+/// Returns false if the file has changed since the stamp was taken.
+/// If it has only been touched (e.g. by a git checkout), updates the time of the stamp and sets `stamp_has_changed`, so that the next loads don't have to hash the whole file again.
+auto is_up_to_date(std::filesystem::path const& path, BinaryMesh_FileStamp& stamp, bool& stamp_has_changed) -> bool
+{
+    auto const current = file_stamp(path, false);
+    if (current.size_in_bytes != stamp.size_in_bytes)
+        return false;
+    if (current.last_write_time == stamp.last_write_time)
+        return true;
+    if (hash_file_content(path) != stamp.content_hash)
+        return false;
+    stamp.last_write_time = current.last_write_time;
+    stamp_has_changed     = true;
+    return true;
+}
+
+/// Padded so that what follows stays aligned.
+auto serialize_material_files(std::vector<BinaryMesh_MaterialFile> const& material_files) -> std::vector<char>
+{
+    auto       result      = std::vector<char>{};
+    auto const write_bytes = [&](void const* ptr, size_t size) {
+        result.insert(result.end(), static_cast<char const*>(ptr), static_cast<char const*>(ptr) + size); // NOLINT(*pointer-arithmetic)
+    };
+    for (auto const& file : material_files)
+    {
+        auto const path = file.relative_path.generic_string();
+        auto const size = static_cast<uint32_t>(path.size());
+        write_bytes(&file.stamp, sizeof(file.stamp));
+        write_bytes(&size, sizeof(size));
+        write_bytes(path.data(), path.size());
+    }
+    result.resize((result.size() + 7) / 8 * 8);
+    return result;
+}
+
+/// Returns nullopt if the bytes are invalid
+auto parse_material_files(std::span<char const> bytes, uint32_t count) -> std::optional<std::vector<BinaryMesh_MaterialFile>>
+{
+    auto const read_bytes = [&](void* ptr, size_t size) {
+        if (bytes.size() < size)
+            return false;
+        std::memcpy(ptr, bytes.data(), size);
+        bytes = bytes.subspan(size);
+        return true;
+    };
+    auto result = std::vector<BinaryMesh_MaterialFile>(count);
+    for (auto& file : result)
+    {
+        auto size = uint32_t{};
+        if (!read_bytes(&file.stamp, sizeof(file.stamp)) || !read_bytes(&size, sizeof(size)) || bytes.size() < size)
+            return std::nullopt;
+        file.relative_path = std::string{bytes.data(), size};
+        bytes              = bytes.subspan(size);
+    }
+    return result;
+}
+
+/// Return nullopt if the result overflows, so that a damaged header can't make us read outside of the file
+auto checked_add(uint64_t a, uint64_t b) -> std::optional<uint64_t>
+{
+    if (b > std::numeric_limits<uint64_t>::max() - a)
+        return std::nullopt;
+    return a + b;
+}
+auto checked_multiply(uint64_t a, uint64_t b) -> std::optional<uint64_t>
+{
+    if (a != 0 && b > std::numeric_limits<uint64_t>::max() / a)
+        return std::nullopt;
+    return a * b;
+}
+
+struct SourceInfo {
+    Header                               header{};
+    std::vector<BinaryMesh_MaterialFile> material_files{};
+};
+
+auto read_source_info(std::filesystem::path const& cache_path) -> std::optional<SourceInfo>
+{
+    auto ifs  = std::ifstream{cache_path, std::ios::binary};
+    auto info = SourceInfo{};
+    if (!ifs.read(reinterpret_cast<char*>(&info.header), sizeof(Header)) // NOLINT(*reinterpret-cast)
+        || info.header.magic != magic || info.header.version != format_version)
+        return std::nullopt;
+    auto bytes = std::vector<char>(info.header.material_files_size);
+    if (!ifs.read(bytes.data(), static_cast<std::streamsize>(bytes.size())))
+        return std::nullopt;
+    auto material_files = parse_material_files(bytes, info.header.material_files_count);
+    if (!material_files)
+        return std::nullopt;
+    info.material_files = std::move(*material_files);
+    return info;
+}
+
+/// Replaces the header and the material files, and keeps the rest of the file. The paths of the material files must not have changed, so that their size doesn't change either.
+void rewrite_source_info(std::filesystem::path const& cache_path, SourceInfo const& info)
+{
+    // Write to a temporary file first, so that another process never sees a half-written cache
+    auto tmp_path = cache_path;
+    tmp_path += ".tmp";
+    auto error = std::error_code{};
+    {
+        auto const material_files = serialize_material_files(info.material_files);
+        auto       ifs            = std::ifstream{cache_path, std::ios::binary};
+        auto       ofs            = std::ofstream{tmp_path, std::ios::binary | std::ios::trunc};
+        ofs.write(reinterpret_cast<char const*>(&info.header), sizeof(info.header)); // NOLINT(*reinterpret-cast)
+        ofs.write(material_files.data(), static_cast<std::streamsize>(material_files.size()));
+        ifs.seekg(static_cast<std::streamoff>(sizeof(Header) + info.header.material_files_size));
+        ofs << ifs.rdbuf();
+        if (!ifs || !ofs)
+        {
+            ofs.close();
+            std::filesystem::remove(tmp_path, error);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, cache_path, error);
+}
+
+} // namespace
+
+auto binary_mesh_source(std::filesystem::path const& obj_absolute_path, std::span<std::filesystem::path const> material_files, uint64_t options_hash) -> BinaryMesh_Source
+{
+    auto source = BinaryMesh_Source{
+        .obj          = file_stamp(obj_absolute_path, true),
+        .options_hash = options_hash,
+    };
+    for (auto const& material_file : material_files)
+    {
+        source.material_files.push_back({
+            .relative_path = material_file,
+            .stamp         = file_stamp(obj_absolute_path.parent_path() / material_file, true),
+        });
+    }
+    return source;
+}
+
+auto BinaryMesh::open(std::filesystem::path const& cache_path, std::filesystem::path const& source_absolute_path, uint64_t options_hash) -> std::optional<BinaryMesh>
+{
+    if (!std::filesystem::exists(cache_path))
+        return std::nullopt;
+
+    // The source info is checked before mapping the file, because we might have to rewrite it
+    auto maybe_info = read_source_info(cache_path);
+    if (!maybe_info || maybe_info->header.options_hash != options_hash)
+        return std::nullopt;
+    auto& info = *maybe_info;
+
+    { // Check that the source files haven't changed
+        bool stamps_have_changed = false;
+        if (!is_up_to_date(source_absolute_path, info.header.obj, stamps_have_changed))
+            return std::nullopt;
+        for (auto& material_file : info.material_files)
+        {
+            if (!is_up_to_date(source_absolute_path.parent_path() / material_file.relative_path, material_file.stamp, stamps_have_changed))
+                return std::nullopt;
+        }
+        if (stamps_have_changed)
+            rewrite_source_info(cache_path, info);
+    }
+    auto const& header = info.header;
+
+    auto       mesh  = BinaryMesh{MappedFile{cache_path}};
+    auto const bytes = mesh._file.bytes();
+    if (bytes.size() < sizeof(Header))
+        return std::nullopt;
+
+    // All the sizes come from the file, so we make sure that they can't make us read outside of it
+    auto const attributes_offset  = uint64_t{sizeof(Header)} + header.material_files_size;
+    auto const vertex_data_offset = attributes_offset + uint64_t{header.attributes_count} * sizeof(Attribute); // Can't overflow, these are 32-bit values
+    auto const indices_size       = checked_multiply(header.indices_count, sizeof(uint32_t));
+    auto const indices_offset     = checked_add(vertex_data_offset, header.vertex_data_size);
+    if (!indices_size || !indices_offset)
+        return std::nullopt;
+    auto const submeshes_offset = checked_add(*indices_offset, *indices_size);
+    if (!submeshes_offset || bytes.size() < *submeshes_offset)
+        return std::nullopt;
+
+    for (uint32_t i = 0; i < header.attributes_count; ++i)
+    {
+        auto attribute = Attribute{};
+        std::memcpy(&attribute, bytes.data() + attributes_offset + i * sizeof(Attribute), sizeof(Attribute));
+        auto const maybe_attribute = make_attribute(attribute);
+        if (!maybe_attribute)
+            return std::nullopt;
+        mesh._layout.push_back(*maybe_attribute);
+    }
+
+    { // Check that the vertex data matches the layout, and that the indices only reference existing vertices
+        auto const stride = vertex_stride(mesh._layout);
+        if (stride <= 0 || header.vertex_stride != static_cast<uint32_t>(stride) || header.vertex_data_size % header.vertex_stride != 0)
+            return std::nullopt;
+        mesh._vertex_data         = bytes.subspan(vertex_data_offset, header.vertex_data_size);
+        mesh._indices             = {reinterpret_cast<uint32_t const*>(bytes.data() + *indices_offset), header.indices_count}; // NOLINT(*reinterpret-cast)
+        auto const vertices_count = header.vertex_data_size / header.vertex_stride;
+        if (!mesh._indices.empty() && *std::max_element(mesh._indices.begin(), mesh._indices.end()) >= vertices_count)
+            return std::nullopt;
+    }
+
+    auto submeshes_bytes = bytes.subspan(*submeshes_offset);
+    for (uint32_t i = 0; i < header.submeshes_count; ++i)
+    {
+        auto const submesh = read_submesh(submeshes_bytes);
+        if (!submesh || uint64_t{submesh->range.first_index} + submesh->range.indices_count > header.indices_count)
+            return std::nullopt;
+        mesh._submeshes.push_back(*submesh);
+    }
+    if (!submeshes_bytes.empty())
+        return std::nullopt;
+
+    mesh._bounding_box = BoundingBox{
+        .min = glm::vec3{header.bounds_min[0], header.bounds_min[1], header.bounds_min[2]},
+        .max = glm::vec3{header.bounds_max[0], header.bounds_max[1], header.bounds_max[2]},
+    };
+    return mesh;
+}
+
+auto BinaryMesh::write(std::filesystem::path const& cache_path, MeshData const& data, BinaryMesh_Source const& source) -> bool
+{
+    auto const bbox           = data.bounding_box();
+    auto const material_files = serialize_material_files(source.material_files);
+    auto const header         = Header{
+        .magic                = magic,
+        .version              = format_version,
+        .obj                  = source.obj,
+        .options_hash         = source.options_hash,
+        .material_files_count = static_cast<uint32_t>(source.material_files.size()),
+        .material_files_size  = static_cast<uint32_t>(material_files.size()),
+        .attributes_count     = static_cast<uint32_t>(data.layout.size()),
+        .vertex_stride        = static_cast<uint32_t>(data.vertex_stride()),
+        .vertex_data_size     = data.vertices.size(),
+        .indices_count        = data.indices.size(),
+        .bounds_min           = {bbox.min.x, bbox.min.y, bbox.min.z},
+        .bounds_max           = {bbox.max.x, bbox.max.y, bbox.max.z},
+        .submeshes_count      = static_cast<uint32_t>(data.submeshes.size()),
+    };
+
+    // Write to a temporary file first, so that another process never sees a half-written cache
+    auto tmp_path = cache_path;
+    tmp_path += ".tmp";
+    {
+        auto ofs = std::ofstream{tmp_path, std::ios::binary | std::ios::trunc};
+        if (!ofs)
+            return false;
+        auto const write_bytes = [&](void const* ptr, size_t size) {
+            ofs.write(static_cast<char const*>(ptr), static_cast<std::streamsize>(size));
+        };
+        write_bytes(&header, sizeof(header));
+        write_bytes(material_files.data(), material_files.size());
+        for (auto const& attribute : data.layout)
+        {
+            auto const attr = Attribute{
+                .index = std::visit([](auto&& attr) { return attr.index(); }, attribute),
+                .kind  = static_cast<uint32_t>(attribute.index()),
+            };
+            write_bytes(&attr, sizeof(attr));
+        }
+        write_bytes(data.vertices.data(), header.vertex_data_size);
+        write_bytes(data.indices.data(), data.indices.size() * sizeof(uint32_t));
+        for (auto const& submesh : data.submeshes)
+            write_submesh(ofs, submesh);
+        if (!ofs)
+            return false;
+    }
+    auto error = std::error_code{};
+    std::filesystem::rename(tmp_path, cache_path, error);
+    return !error;
+}
+
+auto BinaryMesh::to_mesh() const -> Mesh
+{
+    return Mesh{MeshBytes_Descriptor{
+        .layout       = _layout,
+        .vertex_data  = _vertex_data,
+        .index_buffer = _indices,
+        .submeshes    = _submeshes,
+    }};
+}
+
+auto BinaryMesh::to_mesh_data() const -> MeshData
+{
+    return MeshData{
+        .layout    = _layout,
+        .vertices  = {_vertex_data.begin(), _vertex_data.end()},
+        .indices   = {_indices.begin(), _indices.end()},
+        .submeshes = _submeshes,
+    };
+}
+
+} // namespace gl::internal
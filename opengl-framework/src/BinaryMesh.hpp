@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+
+namespace gl::internal {
+
+/// Identifies the content of a file, so that we can detect when it changes.
+struct BinaryMesh_FileStamp {
+    uint64_t content_hash{};
+    uint64_t size_in_bytes{};
+    int64_t  last_write_time{};
+};
+
+/// A .mtl file used by the .obj.
+struct BinaryMesh_MaterialFile {
+    std::filesystem::path relative_path{}; // Relative to the folder of the .obj, so that the cache stays valid when the whole folder is moved
+    BinaryMesh_FileStamp  stamp{};
+};
+
+/// Identifies the files (and the import options) a binary mesh has been generated from, so that we can detect when the cache is stale.
+struct BinaryMesh_Source {
+    BinaryMesh_FileStamp                 obj{};
+    std::vector<BinaryMesh_MaterialFile> material_files{};
+    uint64_t                             options_hash{};
+};
+
+/// `material_files` must be relative to the folder of the .obj. They don't have to exist (a missing file is also a valid state, and the cache becomes stale when it appears).
+auto binary_mesh_source(std::filesystem::path const& obj_absolute_path, std::span<std::filesystem::path const> material_files, uint64_t options_hash) -> BinaryMesh_Source;
+
+/// A compact binary container that can be memory-mapped and sent straight to the GPU.
+/// Layout: header, material files, vertex attributes, interleaved vertex data, indices, submeshes.
+class BinaryMesh {
+public:
+    /// Returns nullopt if the file doesn't exist, is invalid, was written by another version of the format, or was generated from other sources (the .obj or any of its .mtl files).
+    static auto open(std::filesystem::path const& cache_path, std::filesystem::path const& source_absolute_path, uint64_t options_hash) -> std::optional<BinaryMesh>;
+    /// Returns false if the file could not be written.
+    static auto write(std::filesystem::path const& cache_path, MeshData const&, BinaryMesh_Source const&) -> bool;
+
+    auto layout() const -> std::vector<AnyVertexAttribute> const& { return _layout; }
+    auto vertex_data() const -> std::span<std::byte const> { return _vertex_data; }
+    auto indices() const -> std::span<uint32_t const> { return _indices; }
+    auto bounding_box() const -> BoundingBox const& { return _bounding_box; }
+    auto submeshes() const -> std::vector<Submesh> const& { return _submeshes; }
+
+    auto to_mesh() const -> Mesh;
+    auto to_mesh_data() const -> MeshData;
+
+private:
+    explicit BinaryMesh(MappedFile file)
+        : _file{std::move(file)}
+    {}
+
+private:
+    MappedFile                      _file;
+    std::vector<AnyVertexAttribute> _layout{};
+    std::span<std::byte const>      _vertex_data{};
+    std::span<uint32_t const>       _indices{};
+    BoundingBox                     _bounding_box{};
+    std::vector<Submesh>            _submeshes{};
+};
+
+} // namespace gl::internal
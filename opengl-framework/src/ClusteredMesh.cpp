@@ -0,0 +1,182 @@
+#include "ClusteredMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace gl {
+
+namespace {
+
+auto make_meshlet(MeshData const& data, size_t first_triangle, size_t end_triangle) -> Meshlet
+{
+    auto meshlet  = Meshlet{};
+    meshlet.range = IndexRange{
+        .first_index   = static_cast<uint32_t>(first_triangle * 3),
+        .indices_count = static_cast<uint32_t>((end_triangle - first_triangle) * 3),
+    };
+
+    // Bounding sphere
+    auto bbox = BoundingBox{.min = glm::vec3{std::numeric_limits<float>::max()}, .max = glm::vec3{std::numeric_limits<float>::lowest()}};
+    for (uint32_t i = meshlet.range.first_index; i < meshlet.range.first_index + meshlet.range.indices_count; ++i)
+    {
+        auto const position = data.position(data.indices[i]);
+        bbox.min            = glm::min(bbox.min, position);
+        bbox.max            = glm::max(bbox.max, position);
+    }
+    meshlet.center = (bbox.min + bbox.max) / 2.f;
+    for (uint32_t i = meshlet.range.first_index; i < meshlet.range.first_index + meshlet.range.indices_count; ++i)
+        meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, data.position(data.indices[i])));
+
+    // Normal cone
+    auto normals = std::vector<glm::vec3>{};
+    normals.reserve(end_triangle - first_triangle);
+    for (size_t triangle = first_triangle; triangle < end_triangle; ++triangle)
+    {
+        auto const p0     = data.position(data.indices[triangle * 3 + 0]);
+        auto const p1     = data.position(data.indices[triangle * 3 + 1]);
+        auto const p2     = data.position(data.indices[triangle * 3 + 2]);
+        auto const normal = glm::cross(p1 - p0, p2 - p0);
+        auto const length = glm::length(normal);
+        if (length > 0.f) // Degenerate triangles are never visible anyways
+            normals.push_back(normal / length);
+    }
+    auto axis = glm::vec3{0.f};
+    for (auto const& normal : normals)
+        axis += normal;
+    auto const axis_length = glm::length(axis);
+    if (normals.empty() || axis_length < 1e-4f * static_cast<float>(normals.size())) // The normals point in all directions, there is no meaningful cone
+        return meshlet;
+    axis /= axis_length;
+
+    auto min_dot = 1.f;
+    for (auto const& normal : normals)
+        min_dot = std::min(min_dot, glm::dot(normal, axis));
+    if (min_dot <= 0.f) // The cone is more than a half-space, there is always a triangle facing the camera
+        return meshlet;
+
+    meshlet.cone_axis   = axis;
+    meshlet.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+    return meshlet;
+}
+
+/// Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix".
+/// The planes are not normalized, and point towards the inside of the frustum.
+auto frustum_planes(glm::mat4 const& mvp) -> std::array<glm::vec4, 6>
+{
+    auto const row = [&](int i) { return glm::vec4{mvp[0][i], mvp[1][i], mvp[2][i], mvp[3][i]}; };
+    return {
+        row(3) + row(0), // Left
+        row(3) - row(0), // Right
+        row(3) + row(1), // Bottom
+        row(3) - row(1), // Top
+        row(3) + row(2), // Near
+        row(3) - row(2), // Far (which is degenerate and never culls anything with an infinite projection matrix, as expected)
+    };
+}
+
+auto is_outside_frustum(std::array<glm::vec4, 6> const& planes, Meshlet const& meshlet) -> bool
+{
+    return std::any_of(planes.begin(), planes.end(), [&](glm::vec4 const& plane) {
+        auto const normal = glm::vec3{plane};
+        return glm::dot(normal, meshlet.center) + plane.w < -meshlet.radius * glm::length(normal);
+    });
+}
+
+/// True when all the triangles face away from the camera, wherever they are in the bounding sphere.
+auto is_back_facing(Meshlet const& meshlet, glm::vec3 const& camera_position) -> bool
+{
+    if (meshlet.cone_cutoff > 1.f)
+        return false;
+    auto const camera_to_center = meshlet.center - camera_position;
+    return glm::dot(camera_to_center, meshlet.cone_axis) >= meshlet.cone_cutoff * glm::length(camera_to_center) + meshlet.radius;
+}
+
+} // namespace
+
+auto build_meshlets(MeshData const& data, BuildMeshlets_Options const& options) -> std::vector<Meshlet>
+{
+    assert(options.max_vertices >= 3 && options.max_triangles >= 1);
+    assert(!data.layout.empty() && std::holds_alternative<VertexAttribute::Position3D>(data.layout[0]));
+
+    static constexpr auto not_used = std::numeric_limits<uint32_t>::max();
+
+    auto meshlets        = std::vector<Meshlet>{};
+    auto last_meshlet_id = std::vector<uint32_t>(data.vertices_count(), not_used); // Id of the last meshlet that used each vertex, so that we can count the unique vertices in a meshlet
+
+    auto const triangles_count = data.indices.size() / 3;
+    size_t     first_triangle  = 0;
+    size_t     vertices_count  = 0;
+    auto const new_vertices    = [&](size_t triangle) {
+        auto const id = static_cast<uint32_t>(meshlets.size());
+        auto const i0 = data.indices[triangle * 3 + 0];
+        auto const i1 = data.indices[triangle * 3 + 1];
+        auto const i2 = data.indices[triangle * 3 + 2];
+        return static_cast<size_t>(last_meshlet_id[i0] != id)
+               + static_cast<size_t>(last_meshlet_id[i1] != id && i1 != i0)
+               + static_cast<size_t>(last_meshlet_id[i2] != id && i2 != i0 && i2 != i1);
+    };
+
+    for (size_t triangle = 0; triangle < triangles_count; ++triangle)
+    {
+        if (triangle - first_triangle == options.max_triangles
+            || vertices_count + new_vertices(triangle) > options.max_vertices)
+        {
+            meshlets.push_back(make_meshlet(data, first_triangle, triangle));
+            first_triangle = triangle;
+            vertices_count = 0;
+        }
+        vertices_count += new_vertices(triangle);
+        for (size_t k = 0; k < 3; ++k)
+            last_meshlet_id[data.indices[triangle * 3 + k]] = static_cast<uint32_t>(meshlets.size());
+    }
+    if (first_triangle < triangles_count)
+        meshlets.push_back(make_meshlet(data, first_triangle, triangles_count));
+
+    return meshlets;
+}
+
+void cull_meshlets(std::span<Meshlet const> meshlets, glm::mat4 const& model_view_projection_matrix, glm::vec3 const& camera_position_in_object_space, std::vector<IndexRange>& visible_ranges, MeshletCulling_Stats* stats)
+{
+    auto const planes = frustum_planes(model_view_projection_matrix);
+    auto       result = MeshletCulling_Stats{.meshlets_count = meshlets.size()};
+    for (auto const& meshlet : meshlets)
+    {
+        if (is_outside_frustum(planes, meshlet))
+        {
+            result.culled_by_frustum++;
+            continue;
+        }
+        if (is_back_facing(meshlet, camera_position_in_object_space))
+        {
+            result.culled_by_cone++;
+            continue;
+        }
+        visible_ranges.push_back(meshlet.range);
+        result.triangles_drawn += meshlet.range.indices_count / 3;
+    }
+    if (stats)
+        *stats = result;
+}
+
+ClusteredMesh::ClusteredMesh(MeshData const& data, BuildMeshlets_Options const& options)
+    : _mesh{MeshBytes_Descriptor{
+          .layout       = data.layout,
+          .vertex_data  = data.vertices,
+          .index_buffer = data.indices,
+          .submeshes    = data.submeshes,
+      }}
+    , _meshlets{build_meshlets(data, options)}
+{}
+
+void ClusteredMesh::draw(glm::mat4 const& model_matrix, glm::mat4 const& view_projection_matrix, glm::vec3 const& camera_position)
+{
+    auto const camera_position_in_object_space = glm::vec3{glm::inverse(model_matrix) * glm::vec4{camera_position, 1.f}};
+
+    _visible_ranges.clear();
+    cull_meshlets(_meshlets, view_projection_matrix * model_matrix, camera_position_in_object_space, _visible_ranges, &_stats);
+    _mesh.draw_ranges(_visible_ranges);
+}
+
+} // namespace gl
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+/// A small group of neighbouring triangles, that can be culled as a whole.
+struct Meshlet {
+    IndexRange range{};
+    /// Bounding sphere, in object space
+    glm::vec3 center{0.f};
+    float     radius{};
+    /// All the triangles' normals are within this cone. The whole meshlet is back-facing when seen from inside the "back" of the cone.
+    glm::vec3 cone_axis{0.f};
+    /// Sine of the angle of the cone. Greater than 1 when the cone is too wide for the meshlet to ever be entirely back-facing.
+    float cone_cutoff{2.f};
+};
+
+struct BuildMeshlets_Options {
+    size_t max_vertices{64};
+    size_t max_triangles{124};
+};
+
+/// Splits the mesh into groups of consecutive triangles of the index buffer.
+/// The index buffer should already be ordered so that consecutive triangles are close to each other, which is what optimize_mesh() does (and load_obj() calls it by default).
+/// Requires the first attribute of the layout to be a Position3D.
+auto build_meshlets(MeshData const&, BuildMeshlets_Options const& = {}) -> std::vector<Meshlet>;
+
+struct MeshletCulling_Stats {
+    size_t meshlets_count{};
+    size_t culled_by_frustum{};
+    size_t culled_by_cone{};
+    size_t triangles_drawn{};
+};
+
+/// `model_view_projection_matrix` and `camera_position_in_object_space` allow us to do all the tests in object space, without having to transform the meshlets.
+/// Appends the ranges of the visible meshlets to `visible_ranges`.
+void cull_meshlets(std::span<Meshlet const>, glm::mat4 const& model_view_projection_matrix, glm::vec3 const& camera_position_in_object_space, std::vector<IndexRange>& visible_ranges, MeshletCulling_Stats* stats = nullptr);
+
+/// A Mesh that is split into meshlets, and only draws the ones that are visible by the camera.
+/// Very effective on big and detailed meshes, where most of the triangles are either out of view or facing away from the camera.
+/// NB: cone culling assumes that the triangles are counter-clockwise when seen from the front, and that you don't need to see their back faces.
+class ClusteredMesh {
+public:
+    explicit ClusteredMesh(MeshData const&, BuildMeshlets_Options const& = {});
+
+    /// Culls the meshlets and draws the visible ones in a single draw call.
+    /// `model_matrix` is the same one you send to your shader to position the mesh in the world.
+    void draw(glm::mat4 const& model_matrix, glm::mat4 const& view_projection_matrix, glm::vec3 const& camera_position);
+
+    auto mesh() const -> Mesh const& { return _mesh; }
+    auto meshlets() const -> std::vector<Meshlet> const& { return _meshlets; }
+    /// Stats of the last call to draw()
+    auto stats() const -> MeshletCulling_Stats const& { return _stats; }
+
+private:
+    Mesh                    _mesh;
+    std::vector<Meshlet>    _meshlets;
+    std::vector<IndexRange> _visible_ranges{};
+    MeshletCulling_Stats    _stats{};
+};
+
+} // namespace gl
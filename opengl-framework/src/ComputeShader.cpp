@@ -0,0 +1,38 @@
+#include "ComputeShader.hpp"
+#include "ProgramBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
+
+namespace gl {
+
+static auto compile_compute_shader(ComputeShader_Descriptor const& desc) -> Shader
+{
+    auto stages = std::vector<internal::ShaderStageSource>{};
+    stages.push_back({.stage = GL_COMPUTE_SHADER, .code = internal::inject_defines(internal::load_shader_source(desc.compute), desc.defines)});
+    return internal::compile_program(std::move(stages), desc.binary_cache);
+}
+
+ComputeShader::ComputeShader(ComputeShader_Descriptor const& desc)
+    : Shader{compile_compute_shader(desc)}
+{
+    GLint size[3]{}; // NOLINT(*avoid-c-arrays)
+    glGetProgramiv(id(), GL_COMPUTE_WORK_GROUP_SIZE, size);
+    _work_group_size = glm::uvec3{static_cast<GLuint>(size[0]), static_cast<GLuint>(size[1]), static_cast<GLuint>(size[2])};
+}
+
+void ComputeShader::dispatch(glm::uvec3 groups_count) const
+{
+    bind();
+    glDispatchCompute(groups_count.x, groups_count.y, groups_count.z);
+}
+
+void ComputeShader::dispatch_for(glm::uvec3 invocations_count) const
+{
+    dispatch((invocations_count + _work_group_size - 1u) / _work_group_size);
+}
+
+void memory_barrier(GLbitfield barriers)
+{
+    glMemoryBarrier(barriers);
+}
+
+} // namespace gl
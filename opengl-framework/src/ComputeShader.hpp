@@ -0,0 +1,55 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "Shader.hpp"
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+struct ComputeShader_Descriptor {
+    /// Must declare its work group size, e.g. `layout(local_size_x = 64) in;`. Can use `#include` (see load_shader_source()).
+    AnyShaderSource compute{};
+    /// See Shader_Descriptor::defines.
+    std::vector<std::string> defines{};
+    /// See Shader_Descriptor::binary_cache.
+    bool binary_cache{true};
+};
+
+/// A shader that doesn't draw anything, but runs any computation you want on the GPU, e.g. to simulate particles or cull objects.
+/// It reads and writes StorageBuffers (and images), and you set its uniforms like with any other Shader.
+/// Its results are not visible to the commands that follow until you call memory_barrier().
+class ComputeShader : public Shader {
+public:
+    explicit ComputeShader(ComputeShader_Descriptor const&);
+
+    /// The number of invocations in each work group, as declared in the shader with `layout(local_size_x = ..., local_size_y = ..., local_size_z = ...) in;`.
+    auto work_group_size() const -> glm::uvec3 { return _work_group_size; }
+
+    /// Binds the shader, and runs `groups_count.x * groups_count.y * groups_count.z` work groups.
+    void dispatch(glm::uvec3 groups_count) const;
+    /// Runs enough work groups to have (at least) one invocation per element. The shader must ignore the extra invocations, e.g. with `if (gl_GlobalInvocationID.x >= particles_count) return;`.
+    /// e.g. `dispatch_for({particles_count, 1, 1})` or `dispatch_for({width, height, 1})`.
+    void dispatch_for(glm::uvec3 invocations_count) const;
+
+private:
+    glm::uvec3 _work_group_size{};
+};
+
+/// What the commands that come after a memory_barrier() are going to do with the data written by the previous shaders. You can combine them with |.
+namespace Barrier {
+inline constexpr GLbitfield StorageBuffer   = GL_SHADER_STORAGE_BARRIER_BIT;                                     // Read it from another shader
+inline constexpr GLbitfield VertexBuffer    = GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT; // Draw with it as a vertex, instance or index buffer
+inline constexpr GLbitfield IndirectCommand = GL_COMMAND_BARRIER_BIT;                                            // Use it as the parameters of an indirect draw or dispatch
+inline constexpr GLbitfield Readback        = GL_BUFFER_UPDATE_BARRIER_BIT;                                      // Read it on the CPU, e.g. with StorageBuffer::download()
+inline constexpr GLbitfield Uniform         = GL_UNIFORM_BARRIER_BIT;                                            // Read it as a uniform buffer
+inline constexpr GLbitfield Texture         = GL_TEXTURE_FETCH_BARRIER_BIT;                                      // Sample it as a texture
+inline constexpr GLbitfield Image           = GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;                                // Read it as an image from another shader
+inline constexpr GLbitfield All             = GL_ALL_BARRIER_BITS;
+} // namespace Barrier
+
+/// Makes the writes done by the previous shaders visible to the commands that come after, e.g. `gl::memory_barrier(gl::Barrier::StorageBuffer | gl::Barrier::VertexBuffer);`
+/// Only use the barriers that you need, each one can force the GPU to wait for the previous commands to be done.
+void memory_barrier(GLbitfield barriers);
+
+} // namespace gl
@@ -0,0 +1,203 @@
+#include "DrawBatch.hpp"
+#include <array>
+#include <cassert>
+#include <numeric>
+#include <utility>
+#include "StateCache.hpp"
+#include "grow_buffer.hpp"
+#include "handle_error.hpp"
+
+namespace gl {
+
+namespace {
+
+auto supports_multi_draw_indirect() -> bool
+{
+    return GLAD_GL_VERSION_4_3 != 0;
+}
+
+} // namespace
+
+DrawBatch::DrawBatch(DrawBatch_Descriptor desc)
+    : _desc{std::move(desc)}
+{
+    if (_desc.per_draw_data_size > 0 && !supports_multi_draw_indirect())
+        handle_error("[DrawBatch] Per-draw data requires OpenGL 4.3 (for shader storage buffers), which is not available on your machine.");
+
+    create_vertex_array();
+    glGenBuffers(1, &_indirect_buffer);
+    glGenBuffers(1, &_per_draw_data_buffer);
+}
+
+void DrawBatch::create_vertex_array()
+{
+    glGenVertexArrays(1, &_vertex_array);
+    glGenBuffers(1, &_vertex_buffer);
+    glGenBuffers(1, &_index_buffer);
+    glGenBuffers(1, &_draw_id_buffer);
+    StateCache::bind_vertex_array(_vertex_array);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    if (supports_multi_draw_indirect())
+    {
+        // The draw id is an instanced attribute, and each draw starts at a different instance (its base_instance), so it reads a different value from this buffer
+        glBindBuffer(GL_ARRAY_BUFFER, _draw_id_buffer);
+        glEnableVertexAttribArray(_desc.draw_id_location);
+        glVertexAttribIPointer(_desc.draw_id_location, 1, GL_UNSIGNED_INT, 0, nullptr);
+        glVertexAttribDivisor(_desc.draw_id_location, 1);
+    }
+}
+
+void DrawBatch::reserve_geometry(size_t vertices_bytes, size_t indices_count)
+{
+    if (vertices_bytes > _vertices_capacity)
+    {
+        _vertices_capacity = internal::grown_capacity(_vertices_capacity, vertices_bytes);
+        internal::grow_buffer(_vertex_buffer, _vertices_bytes, _vertices_capacity);
+        StateCache::bind_vertex_array(_vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+        internal::set_vertex_attributes(_desc.layout); // The vertex array needs to point to the new buffer
+    }
+    if (indices_count > _indices_capacity)
+    {
+        _indices_capacity = internal::grown_capacity(_indices_capacity, indices_count);
+        internal::grow_buffer(_index_buffer, _indices_count * sizeof(uint32_t), _indices_capacity * sizeof(uint32_t));
+        StateCache::bind_vertex_array(_vertex_array);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    }
+}
+
+auto DrawBatch::add_mesh(MeshData const& data) -> BatchedMesh
+{
+    assert(internal::layouts_are_equal(data.layout, _desc.layout) && "All the meshes of a DrawBatch must have the same layout.");
+    assert(!data.indices.empty() && "DrawBatch only supports meshes with an index buffer.");
+
+    reserve_geometry(_vertices_bytes + data.vertices.size(), _indices_count + data.indices.size());
+
+    auto const mesh = BatchedMesh{
+        .first_index   = static_cast<uint32_t>(_indices_count),
+        .indices_count = static_cast<uint32_t>(data.indices.size()),
+        .base_vertex   = static_cast<int32_t>(_vertices_bytes / data.vertex_stride()),
+    };
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _vertex_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(_vertices_bytes), static_cast<GLsizeiptr>(data.vertices.size()), data.vertices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _index_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(_indices_count * sizeof(uint32_t)), static_cast<GLsizeiptr>(data.indices.size() * sizeof(uint32_t)), data.indices.data());
+
+    _vertices_bytes += data.vertices.size();
+    _indices_count += data.indices.size();
+    return mesh;
+}
+
+void DrawBatch::clear_draws()
+{
+    _commands.clear();
+    _per_draw_data.clear();
+}
+
+void DrawBatch::add_draw(BatchedMesh const& mesh, std::span<std::byte const> per_draw_data)
+{
+    assert(per_draw_data.size() == _desc.per_draw_data_size && "The size of the per-draw data doesn't match DrawBatch_Descriptor::per_draw_data_size.");
+    _commands.push_back(DrawCommand{
+        .count          = mesh.indices_count,
+        .instance_count = 1,
+        .first_index    = mesh.first_index,
+        .base_vertex    = mesh.base_vertex,
+        .base_instance  = static_cast<uint32_t>(_commands.size()), // This is what gives its value to the draw id
+    });
+    _per_draw_data.insert(_per_draw_data.end(), per_draw_data.begin(), per_draw_data.end());
+}
+
+void DrawBatch::draw()
+{
+    if (_commands.empty())
+        return;
+
+    StateCache::bind_vertex_array(_vertex_array);
+    if (!supports_multi_draw_indirect())
+    {
+        for (size_t i = 0; i < _commands.size(); ++i)
+        {
+            auto const& command = _commands[i];
+            glVertexAttribI1ui(_desc.draw_id_location, static_cast<GLuint>(i)); // The attribute isn't an array, so it has the same value for all the vertices of the draw
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(command.count), GL_UNSIGNED_INT, reinterpret_cast<void const*>(command.first_index * sizeof(uint32_t)), command.base_vertex); // NOLINT(*reinterpret-cast, *no-int-to-ptr)
+        }
+        return;
+    }
+
+    if (_commands.size() > _draw_ids_capacity)
+    {
+        _draw_ids_capacity = internal::grown_capacity(_draw_ids_capacity, _commands.size());
+        auto draw_ids      = std::vector<uint32_t>(_draw_ids_capacity);
+        std::iota(draw_ids.begin(), draw_ids.end(), 0);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _draw_id_buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(draw_ids.size() * sizeof(uint32_t)), draw_ids.data(), GL_STATIC_DRAW);
+    }
+
+    // Calling glBufferData() each frame lets the driver give us a fresh buffer if the previous one is still in use by the GPU
+    if (!_per_draw_data.empty())
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, _per_draw_data_buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(_per_draw_data.size()), _per_draw_data.data(), GL_STREAM_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, _desc.per_draw_data_binding, _per_draw_data_buffer);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, _indirect_buffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<GLsizeiptr>(_commands.size() * sizeof(DrawCommand)), _commands.data(), GL_STREAM_DRAW);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(_commands.size()), 0);
+}
+
+DrawBatch::~DrawBatch()
+{
+    internal::state_cache_forget_vertex_array(_vertex_array);
+    glDeleteVertexArrays(1, &_vertex_array);
+    auto const buffers = std::array{_vertex_buffer, _index_buffer, _draw_id_buffer, _indirect_buffer, _per_draw_data_buffer};
+    glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+}
+
+DrawBatch::DrawBatch(DrawBatch&& o) noexcept
+    : _desc{std::move(o._desc)}
+    , _vertex_array{std::exchange(o._vertex_array, 0)}
+    , _vertex_buffer{std::exchange(o._vertex_buffer, 0)}
+    , _index_buffer{std::exchange(o._index_buffer, 0)}
+    , _draw_id_buffer{std::exchange(o._draw_id_buffer, 0)}
+    , _indirect_buffer{std::exchange(o._indirect_buffer, 0)}
+    , _per_draw_data_buffer{std::exchange(o._per_draw_data_buffer, 0)}
+    , _vertices_bytes{o._vertices_bytes}
+    , _vertices_capacity{o._vertices_capacity}
+    , _indices_count{o._indices_count}
+    , _indices_capacity{o._indices_capacity}
+    , _draw_ids_capacity{o._draw_ids_capacity}
+    , _commands{std::move(o._commands)}
+    , _per_draw_data{std::move(o._per_draw_data)}
+{}
+
+auto DrawBatch::operator=(DrawBatch&& o) noexcept -> DrawBatch&
+{
+    if (this != &o)
+    {
+        // Delete this
+        internal::state_cache_forget_vertex_array(_vertex_array);
+        glDeleteVertexArrays(1, &_vertex_array);
+        auto const buffers = std::array{_vertex_buffer, _index_buffer, _draw_id_buffer, _indirect_buffer, _per_draw_data_buffer};
+        glDeleteBuffers(static_cast<GLsizei>(buffers.size()), buffers.data());
+
+        // Move
+        _desc                 = std::move(o._desc);
+        _vertex_array         = std::exchange(o._vertex_array, 0);
+        _vertex_buffer        = std::exchange(o._vertex_buffer, 0);
+        _index_buffer         = std::exchange(o._index_buffer, 0);
+        _draw_id_buffer       = std::exchange(o._draw_id_buffer, 0);
+        _indirect_buffer      = std::exchange(o._indirect_buffer, 0);
+        _per_draw_data_buffer = std::exchange(o._per_draw_data_buffer, 0);
+        _vertices_bytes       = o._vertices_bytes;
+        _vertices_capacity    = o._vertices_capacity;
+        _indices_count        = o._indices_count;
+        _indices_capacity     = o._indices_capacity;
+        _draw_ids_capacity    = o._draw_ids_capacity;
+        _commands             = std::move(o._commands);
+        _per_draw_data        = std::move(o._per_draw_data);
+    }
+    return *this;
+}
+
+} // namespace gl
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+/// Where a mesh lives inside the buffers of a DrawBatch.
+struct BatchedMesh {
+    uint32_t first_index{};
+    uint32_t indices_count{};
+    int32_t  base_vertex{};
+};
+
+struct DrawBatch_Descriptor {
+    /// All the meshes of the batch must have this layout.
+    std::vector<AnyVertexAttribute> layout{};
+    /// Location of a `uint` vertex attribute that receives the index of the draw (it is the equivalent of gl_DrawID). Must not be used by the layout.
+    /// In your vertex shader, declare it as `layout(location = 15) in uint draw_id;` and use it to read your per-draw data.
+    GLuint draw_id_location{15};
+    /// Size in bytes of the data attached to each draw (e.g. sizeof(glm::mat4) for a transform matrix), or 0 if you don't need any.
+    /// It is stored in a shader storage buffer, that you can declare as `layout(std430, binding = 0) buffer PerDraw { mat4 transforms[]; };`.
+    /// NB: storage buffers require OpenGL 4.3, so they are not available on MacOS.
+    size_t per_draw_data_size{0};
+    GLuint per_draw_data_binding{0};
+};
+
+/// Draws many meshes with a single call to glMultiDrawElementsIndirect().
+/// All the meshes are stored in the same vertex and index buffers, so that there is no state to change between two draws.
+/// This makes a huge difference when you have thousands of objects, because the CPU cost of a draw call is paid only once.
+/// On MacOS (where OpenGL is stuck at 4.1) the draws are issued one by one, but still without changing any state in between.
+class DrawBatch {
+public:
+    explicit DrawBatch(DrawBatch_Descriptor);
+    ~DrawBatch();
+    DrawBatch(DrawBatch const&)                    = delete;
+    auto operator=(DrawBatch const&) -> DrawBatch& = delete;
+    DrawBatch(DrawBatch&&) noexcept;
+    auto operator=(DrawBatch&&) noexcept -> DrawBatch&;
+
+    /// Copies the mesh into the buffers of the batch. You only need to do it once, and then you can draw it as many times as you want.
+    auto add_mesh(MeshData const&) -> BatchedMesh;
+
+    /// Must be called at the beginning of each frame, before adding the draws.
+    void clear_draws();
+    /// `per_draw_data` must be exactly DrawBatch_Descriptor::per_draw_data_size bytes.
+    void add_draw(BatchedMesh const&, std::span<std::byte const> per_draw_data = {});
+    template<typename PerDrawData>
+    void add_draw(BatchedMesh const& mesh, PerDrawData const& per_draw_data)
+    {
+        add_draw(mesh, std::as_bytes(std::span{&per_draw_data, 1}));
+    }
+    auto draws_count() const -> size_t { return _commands.size(); }
+
+    /// Issues all the draws that have been added since the last call to clear_draws().
+    void draw();
+
+private:
+    void create_vertex_array();
+    void reserve_geometry(size_t vertices_bytes, size_t indices_count);
+
+private:
+    DrawBatch_Descriptor _desc;
+
+    GLuint _vertex_array{};
+    GLuint _vertex_buffer{};
+    GLuint _index_buffer{};
+    GLuint _draw_id_buffer{};
+    GLuint _indirect_buffer{};
+    GLuint _per_draw_data_buffer{};
+
+    size_t _vertices_bytes{};
+    size_t _vertices_capacity{}; // In bytes
+    size_t _indices_count{};
+    size_t _indices_capacity{};
+    size_t _draw_ids_capacity{};
+
+    /// Same layout as expected by glMultiDrawElementsIndirect()
+    struct DrawCommand {
+        uint32_t count{};
+        uint32_t instance_count{};
+        uint32_t first_index{};
+        int32_t  base_vertex{};
+        uint32_t base_instance{};
+    };
+    std::vector<DrawCommand> _commands{};
+    std::vector<std::byte>   _per_draw_data{};
+};
+
+} // namespace gl
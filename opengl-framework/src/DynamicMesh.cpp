@@ -0,0 +1,171 @@
+#include "DynamicMesh.hpp"
+#include <cassert>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <utility>
+#include "StateCache.hpp"
+#include "gl_extensions.hpp"
+#include "handle_error.hpp"
+
+namespace gl {
+
+namespace {
+
+auto supports_persistent_mapping() -> bool
+{
+    return internal::gl_extensions().BufferStorage != nullptr;
+}
+
+} // namespace
+
+DynamicMesh::DynamicMesh(DynamicMesh_Descriptor desc)
+    : _desc{std::move(desc)}
+    , _stride{static_cast<size_t>(vertex_stride(_desc.layout))}
+{
+    assert(_desc.max_vertices_count > 0);
+    assert(_desc.max_indices_count % 3 == 0 && "You must provide 3 indices for each triangle");
+
+    glGenVertexArrays(1, &_vertex_array);
+    StateCache::bind_vertex_array(_vertex_array);
+    void* mapped_vertices = nullptr;
+    create_buffer(_vertex_buffer, GL_ARRAY_BUFFER, _desc.max_vertices_count * _stride, &mapped_vertices);
+    internal::set_vertex_attributes(_desc.layout);
+    _mapped_vertices = static_cast<std::byte*>(mapped_vertices);
+    if (_desc.max_indices_count > 0)
+    {
+        void* mapped_indices = nullptr;
+        create_buffer(_maybe_index_buffer, GL_ELEMENT_ARRAY_BUFFER, _desc.max_indices_count * sizeof(uint32_t), &mapped_indices);
+        _mapped_indices = static_cast<uint32_t*>(mapped_indices);
+    }
+}
+
+void DynamicMesh::create_buffer(GLuint& buffer, GLenum target, size_t size_in_bytes, void** mapped_data)
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(target, buffer);
+    if (!supports_persistent_mapping())
+    {
+        glBufferData(target, static_cast<GLsizeiptr>(size_in_bytes), nullptr, GL_STREAM_DRAW);
+        return;
+    }
+    // The mapping is coherent, so our writes are visible to the GPU without having to flush them explicitly
+    auto const flags = GLbitfield{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+    auto const size  = static_cast<GLsizeiptr>(segments_count * size_in_bytes);
+    internal::gl_extensions().BufferStorage(target, size, nullptr, flags);
+    *mapped_data = glMapBufferRange(target, 0, size, flags);
+}
+
+void DynamicMesh::wait_for_segment(size_t segment_index)
+{
+    auto& fence = _fences[segment_index];
+    if (fence == nullptr)
+        return;
+    // The fence was inserted two updates ago, so in practice the GPU is done with it and we don't actually wait
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max()) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void DynamicMesh::update(std::span<std::byte const> vertex_data, std::span<uint32_t const> indices)
+{
+    assert(vertex_data.size() % _stride == 0 && "The size of the vertex data doesn't match the layout.");
+    assert(indices.size() % 3 == 0 && "You must provide 3 indices for each triangle");
+    assert((indices.empty() || _maybe_index_buffer != 0) && "You must set DynamicMesh_Descriptor::max_indices_count to be able to use indices.");
+    _vertices_count = vertex_data.size() / _stride;
+    _indices_count  = indices.size();
+    if (_vertices_count > _desc.max_vertices_count || _indices_count > _desc.max_indices_count)
+        handle_error(std::format("[DynamicMesh] Too much data: got {} vertices and {} indices, but the mesh was created for at most {} vertices and {} indices.", _vertices_count, _indices_count, _desc.max_vertices_count, _desc.max_indices_count));
+
+    if (!supports_persistent_mapping())
+    {
+        // Orphaning: the driver gives us a fresh buffer if the previous one is still in use by the GPU, instead of waiting for it
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _vertex_buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(_desc.max_vertices_count * _stride), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(vertex_data.size()), vertex_data.data());
+        if (!indices.empty())
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, _maybe_index_buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(_desc.max_indices_count * sizeof(uint32_t)), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, 0, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+        }
+        return;
+    }
+
+    // All the commands issued so far (including the draws of the current segment) must be done before we write into this segment again
+    _fences[_current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _current_segment          = (_current_segment + 1) % segments_count;
+    wait_for_segment(_current_segment);
+
+    std::memcpy(_mapped_vertices + _current_segment * _desc.max_vertices_count * _stride, vertex_data.data(), vertex_data.size()); // NOLINT(*pointer-arithmetic)
+    if (!indices.empty())
+        std::memcpy(_mapped_indices + _current_segment * _desc.max_indices_count, indices.data(), indices.size_bytes()); // NOLINT(*pointer-arithmetic)
+}
+
+void DynamicMesh::draw() const
+{
+    // With orphaning, _current_segment is always 0
+    auto const first_vertex = static_cast<GLint>(_current_segment * _desc.max_vertices_count);
+    StateCache::bind_vertex_array(_vertex_array);
+    if (_indices_count > 0)
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(_indices_count), GL_UNSIGNED_INT, reinterpret_cast<void const*>(_current_segment * _desc.max_indices_count * sizeof(uint32_t)), first_vertex); // NOLINT(*reinterpret-cast, *no-int-to-ptr)
+    else
+        glDrawArrays(GL_TRIANGLES, first_vertex, static_cast<GLsizei>(_vertices_count));
+}
+
+void DynamicMesh::release_gpu_resources()
+{
+    for (auto& fence : _fences)
+    {
+        glDeleteSync(fence); // Silently ignores nullptr
+        fence = nullptr;
+    }
+    internal::state_cache_forget_vertex_array(_vertex_array);
+    glDeleteVertexArrays(1, &_vertex_array);
+    glDeleteBuffers(1, &_vertex_buffer); // Also unmaps the buffers
+    glDeleteBuffers(1, &_maybe_index_buffer);
+}
+
+DynamicMesh::~DynamicMesh()
+{
+    release_gpu_resources();
+}
+
+DynamicMesh::DynamicMesh(DynamicMesh&& o) noexcept
+    : _desc{std::move(o._desc)}
+    , _stride{o._stride}
+    , _vertex_array{std::exchange(o._vertex_array, 0)}
+    , _vertex_buffer{std::exchange(o._vertex_buffer, 0)}
+    , _maybe_index_buffer{std::exchange(o._maybe_index_buffer, 0)}
+    , _mapped_vertices{std::exchange(o._mapped_vertices, nullptr)}
+    , _mapped_indices{std::exchange(o._mapped_indices, nullptr)}
+    , _fences{std::exchange(o._fences, {})}
+    , _current_segment{o._current_segment}
+    , _vertices_count{o._vertices_count}
+    , _indices_count{o._indices_count}
+{}
+
+auto DynamicMesh::operator=(DynamicMesh&& o) noexcept -> DynamicMesh&
+{
+    if (this != &o)
+    {
+        // Delete this
+        release_gpu_resources();
+
+        // Move
+        _desc               = std::move(o._desc);
+        _stride             = o._stride;
+        _vertex_array       = std::exchange(o._vertex_array, 0);
+        _vertex_buffer      = std::exchange(o._vertex_buffer, 0);
+        _maybe_index_buffer = std::exchange(o._maybe_index_buffer, 0);
+        _mapped_vertices    = std::exchange(o._mapped_vertices, nullptr);
+        _mapped_indices     = std::exchange(o._mapped_indices, nullptr);
+        _fences             = std::exchange(o._fences, {});
+        _current_segment    = o._current_segment;
+        _vertices_count     = o._vertices_count;
+        _indices_count      = o._indices_count;
+    }
+    return *this;
+}
+
+} // namespace gl
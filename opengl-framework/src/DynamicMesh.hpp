@@ -0,0 +1,69 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+struct DynamicMesh_Descriptor {
+    std::vector<AnyVertexAttribute> layout{};
+    /// The buffers are allocated once and never resized, so you must know in advance the maximum size of your data.
+    size_t max_vertices_count{};
+    /// Leave it to 0 if you don't use an index buffer.
+    size_t max_indices_count{0};
+};
+
+/// A mesh whose content changes every frame (particles, debug lines, etc.), without stalling the CPU or the GPU.
+/// The buffers are split into 3 parts used one after the other: while the GPU is still drawing the previous frames, we write the next one into another part.
+/// When available (OpenGL 4.4), the buffers are persistently mapped so that update() is a simple memcpy, and fences guarantee that we never overwrite data that the GPU is still reading.
+/// Otherwise (e.g. on MacOS) we fall back to orphaning the buffers, which lets the driver do the same thing behind the scenes.
+class DynamicMesh {
+public:
+    explicit DynamicMesh(DynamicMesh_Descriptor);
+    ~DynamicMesh();
+    DynamicMesh(DynamicMesh const&)                    = delete;
+    auto operator=(DynamicMesh const&) -> DynamicMesh& = delete;
+    DynamicMesh(DynamicMesh&&) noexcept;
+    auto operator=(DynamicMesh&&) noexcept -> DynamicMesh&;
+
+    /// Replaces the whole content of the mesh. Typically called once per frame, before drawing.
+    void update(std::span<std::byte const> vertex_data, std::span<uint32_t const> indices = {});
+    template<typename Vertex>
+    void update(std::span<Vertex const> vertices, std::span<uint32_t const> indices = {})
+    {
+        update(std::as_bytes(vertices), indices);
+    }
+
+    void draw() const;
+
+    /// True iff the buffers are persistently mapped.
+    auto is_persistently_mapped() const -> bool { return _mapped_vertices != nullptr; }
+
+private:
+    void create_buffer(GLuint& buffer, GLenum target, size_t size_in_bytes, void** mapped_data);
+    void wait_for_segment(size_t segment_index);
+    void release_gpu_resources();
+
+private:
+    static constexpr size_t segments_count = 3;
+
+    DynamicMesh_Descriptor _desc;
+    size_t                 _stride;
+
+    GLuint     _vertex_array{};
+    GLuint     _vertex_buffer{};
+    GLuint     _maybe_index_buffer{};
+    std::byte* _mapped_vertices{}; // nullptr if we use orphaning
+    uint32_t*  _mapped_indices{};
+
+    std::array<GLsync, segments_count> _fences{}; // Signaled when the GPU is done with the draws that use each segment
+    size_t                             _current_segment{};
+    size_t                             _vertices_count{};
+    size_t                             _indices_count{};
+};
+
+} // namespace gl
@@ -0,0 +1,52 @@
+#include "InstanceBuffer.hpp"
+#include <utility>
+
+namespace gl {
+
+InstanceBuffer::InstanceBuffer(InstanceBuffer_Descriptor desc)
+    : _layout{std::move(desc.layout)}
+{
+    glGenBuffers(1, &_id);
+}
+
+void InstanceBuffer::upload(std::span<std::byte const> instances_data)
+{
+    auto const stride = static_cast<size_t>(vertex_stride(_layout));
+    assert(instances_data.size() % stride == 0 && "The size of the data doesn't match the layout.");
+    _instances_count = instances_data.size() / stride;
+
+    // Uses the copy target so that we don't mess with the state of whatever vertex array is currently bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(instances_data.size()), instances_data.data(), GL_DYNAMIC_DRAW);
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+    glDeleteBuffers(1, &_id);
+}
+
+InstanceBuffer::InstanceBuffer(InstanceBuffer&& o) noexcept
+    : _layout{std::move(o._layout)}
+    , _id{std::exchange(o._id, 0)}
+    , _instances_count{o._instances_count}
+{}
+
+auto InstanceBuffer::operator=(InstanceBuffer&& o) noexcept -> InstanceBuffer&
+{
+    if (this != &o)
+    {
+        glDeleteBuffers(1, &_id);
+        _layout          = std::move(o._layout);
+        _id              = std::exchange(o._id, 0);
+        _instances_count = o._instances_count;
+    }
+    return *this;
+}
+
+auto pack_transform(glm::mat4 const& transform) -> glm::mat3x4
+{
+    // The columns of the transposed matrix are the rows of the original one, and we keep the first 3
+    return glm::mat3x4{glm::transpose(transform)};
+}
+
+} // namespace gl
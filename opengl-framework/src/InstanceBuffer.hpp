@@ -0,0 +1,52 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+struct InstanceBuffer_Descriptor {
+    /// The attributes of each instance. Their locations must not be used by the layout of the mesh.
+    /// e.g. `{gl::VertexAttribute::Transform{3}}` for a `layout(location = 3) in mat4 transform;`, which uses locations 3 to 6.
+    std::vector<AnyVertexAttribute> layout{};
+};
+
+/// Per-instance data (transform, color, etc.), that you plug into a Mesh with Mesh::set_instance_buffer() and draw with Mesh::draw_instanced().
+/// This lets you draw thousands of copies of a mesh with a single draw call, instead of setting a uniform and calling draw() for each one.
+class InstanceBuffer {
+public:
+    explicit InstanceBuffer(InstanceBuffer_Descriptor);
+    ~InstanceBuffer();
+    InstanceBuffer(InstanceBuffer const&)                    = delete;
+    auto operator=(InstanceBuffer const&) -> InstanceBuffer& = delete;
+    InstanceBuffer(InstanceBuffer&&) noexcept;
+    auto operator=(InstanceBuffer&&) noexcept -> InstanceBuffer&;
+
+    /// Replaces the data of all the instances. The data must match the layout.
+    void upload(std::span<std::byte const> instances_data);
+    /// e.g. `upload(std::span<glm::mat4 const>{transforms})`. `Instance` must have exactly the size described by the layout.
+    template<typename Instance>
+    void upload(std::span<Instance const> instances)
+    {
+        assert(sizeof(Instance) == static_cast<size_t>(vertex_stride(_layout)) && "The size of your type doesn't match the layout.");
+        upload(std::as_bytes(instances));
+    }
+
+    auto instances_count() const -> size_t { return _instances_count; }
+    auto layout() const -> std::vector<AnyVertexAttribute> const& { return _layout; }
+    auto id() const -> GLuint { return _id; }
+
+private:
+    std::vector<AnyVertexAttribute> _layout;
+    GLuint                          _id{};
+    size_t                          _instances_count{};
+};
+
+/// Drops the last row of an affine transform, to store it as a VertexAttribute::Transform_Packed.
+auto pack_transform(glm::mat4 const&) -> glm::mat3x4;
+
+} // namespace gl
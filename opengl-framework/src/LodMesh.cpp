@@ -0,0 +1,86 @@
+#include "LodMesh.hpp"
+#include <algorithm>
+#include <cassert>
+#include <opengl-framework/opengl-framework.hpp>
+#include "optimize_mesh.hpp"
+#include "simplify_mesh.hpp"
+
+namespace gl {
+
+namespace {
+
+/// Index buffer containing all the LODs one after the other
+auto generate_lods(MeshData const& data, LodMesh_Options const& options, std::vector<Lod>& lods) -> std::vector<uint32_t>
+{
+    assert(options.triangles_ratio_per_lod > 0.f && options.triangles_ratio_per_lod < 1.f);
+
+    auto all_indices = data.indices;
+    lods.push_back(Lod{.range = {.first_index = 0, .indices_count = static_cast<uint32_t>(data.indices.size())}, .error = 0.f});
+
+    auto previous_lod = std::vector<uint32_t>{data.indices};
+    while (lods.size() < options.max_lods_count)
+    {
+        auto const target_indices_count = static_cast<size_t>(static_cast<float>(previous_lod.size() / 3) * options.triangles_ratio_per_lod) * 3;
+        auto       simplified           = simplify_mesh(data, previous_lod, target_indices_count);
+        if (static_cast<float>(simplified.indices.size()) > 0.9f * static_cast<float>(previous_lod.size())) // Not worth creating a new LOD
+            break;
+
+        optimize_vertex_cache(simplified.indices, data.vertices_count());
+        lods.push_back(Lod{
+            .range = {.first_index = static_cast<uint32_t>(all_indices.size()), .indices_count = static_cast<uint32_t>(simplified.indices.size())},
+            .error = lods.back().error + simplified.error, // The error is measured against the previous LOD, so we add it up to get a bound on the error against the original mesh
+        });
+        all_indices.insert(all_indices.end(), simplified.indices.begin(), simplified.indices.end());
+        previous_lod = std::move(simplified.indices);
+    }
+    return all_indices;
+}
+
+} // namespace
+
+LodMesh::LodMesh(MeshData const& data, LodMesh_Options const& options)
+    : _mesh{[&]() {
+        auto const indices = generate_lods(data, options, _lods);
+        return Mesh{MeshBytes_Descriptor{
+            .layout       = data.layout,
+            .vertex_data  = data.vertices,
+            .index_buffer = indices, // No submeshes, their ranges would only make sense for the original mesh
+        }};
+    }()}
+{
+    auto const bbox         = data.bounding_box();
+    _bounding_sphere_center = (bbox.min + bbox.max) / 2.f;
+    _bounding_sphere_radius = glm::distance(bbox.min, bbox.max) / 2.f;
+}
+
+auto LodMesh::select_lod(glm::mat4 const& model_matrix, Camera const& camera, glm::mat4 const& projection_matrix, float max_error_in_pixels) const -> size_t
+{
+    auto const scale    = std::max({glm::length(glm::vec3{model_matrix[0]}), glm::length(glm::vec3{model_matrix[1]}), glm::length(glm::vec3{model_matrix[2]})});
+    auto const center   = glm::vec3{model_matrix * glm::vec4{_bounding_sphere_center, 1.f}};
+    auto const distance = glm::distance(camera.position(), center) - _bounding_sphere_radius * scale; // Distance to the closest point of the mesh
+    if (distance <= 0.f)
+        return 0;
+
+    // Size in pixels of one world-space unit, at that distance from the camera
+    auto const pixels_per_unit = projection_matrix[1][1] * static_cast<float>(framebuffer_height_in_pixels()) / 2.f / distance;
+
+    for (size_t i = _lods.size(); i-- > 0;)
+    {
+        if (_lods[i].error * scale * pixels_per_unit <= max_error_in_pixels)
+            return i;
+    }
+    return 0;
+}
+
+void LodMesh::draw(glm::mat4 const& model_matrix, Camera const& camera, glm::mat4 const& projection_matrix, float max_error_in_pixels) const
+{
+    draw_lod(select_lod(model_matrix, camera, projection_matrix, max_error_in_pixels));
+}
+
+void LodMesh::draw_lod(size_t lod_index) const
+{
+    assert(lod_index < _lods.size());
+    _mesh.draw_ranges({&_lods[lod_index].range, 1});
+}
+
+} // namespace gl
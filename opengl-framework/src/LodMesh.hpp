@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "Camera.hpp"
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+/// Level Of Detail
+struct Lod {
+    IndexRange range{};
+    /// Distance between this LOD and the original mesh, in the same unit as the positions of the mesh.
+    float error{};
+};
+
+struct LodMesh_Options {
+    /// Including the original mesh. Less LODs might be generated if the mesh can't be simplified enough.
+    size_t max_lods_count{5};
+    /// Each LOD has (roughly) this ratio of the triangles of the previous one.
+    float triangles_ratio_per_lod{0.5f};
+};
+
+/// A mesh along with several simplified versions of it (see simplify_mesh()), that automatically picks the best one depending on how big the mesh is on screen.
+/// All the LODs share the same vertex buffer, and are just different ranges of the index buffer.
+/// The LODs ignore the submeshes of the MeshData: the simplification doesn't preserve the material boundaries, so each LOD is drawn in one go and you should set a single material before drawing it.
+class LodMesh {
+public:
+    explicit LodMesh(MeshData const&, LodMesh_Options const& = {});
+
+    /// Draws the coarsest LOD whose error, once projected on screen, is smaller than `max_error_in_pixels`.
+    /// `model_matrix` is the same one you send to your shader to position the mesh in the world.
+    void draw(glm::mat4 const& model_matrix, Camera const&, glm::mat4 const& projection_matrix, float max_error_in_pixels = 1.f) const;
+    /// 0 is the original mesh, and lods().size() - 1 is the coarsest one.
+    void draw_lod(size_t lod_index) const;
+    /// Returns the LOD that draw() would use.
+    auto select_lod(glm::mat4 const& model_matrix, Camera const&, glm::mat4 const& projection_matrix, float max_error_in_pixels = 1.f) const -> size_t;
+
+    auto lods() const -> std::vector<Lod> const& { return _lods; }
+
+private:
+    std::vector<Lod> _lods{}; // Must be declared before _mesh, because it is filled while creating the mesh
+    Mesh             _mesh; // Contains all the LODs, so it must never be drawn as a whole
+    glm::vec3        _bounding_sphere_center{};
+    float            _bounding_sphere_radius{};
+};
+
+} // namespace gl
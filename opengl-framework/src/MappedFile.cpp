@@ -0,0 +1,96 @@
+#include "MappedFile.hpp"
+#include <format>
+#include <utility>
+#include "handle_error.hpp"
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace gl::internal {
+
+MappedFile::MappedFile(std::filesystem::path const& absolute_path)
+    : _size{static_cast<size_t>(std::filesystem::file_size(absolute_path))}
+{
+    if (_size == 0) // Mapping an empty file is an error, but there is nothing to map anyways
+        return;
+
+#if defined(_WIN32)
+    _file = CreateFileW(absolute_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        handle_error(std::format("Failed to open file \"{}\".", absolute_path.string()));
+    _mapping = CreateFileMappingW(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping != nullptr)
+        _data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (_data == nullptr)
+    {
+        unmap();
+        handle_error(std::format("Failed to map file \"{}\" in memory.", absolute_path.string()));
+    }
+#else
+    int const fd = open(absolute_path.c_str(), O_RDONLY); // NOLINT(*vararg)
+    if (fd == -1)
+        handle_error(std::format("Failed to open file \"{}\".", absolute_path.string()));
+    void* const data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the file is closed
+    if (data == MAP_FAILED) // NOLINT(*cstyle-cast, performance-no-int-to-ptr)
+        handle_error(std::format("Failed to map file \"{}\" in memory.", absolute_path.string()));
+    _data = data;
+#endif
+}
+
+void MappedFile::unmap()
+{
+#if defined(_WIN32)
+    if (_data != nullptr)
+        UnmapViewOfFile(_data);
+    if (_mapping != nullptr)
+        CloseHandle(_mapping);
+    if (_file != nullptr && _file != INVALID_HANDLE_VALUE)
+        CloseHandle(_file);
+    _file    = nullptr;
+    _mapping = nullptr;
+#else
+    if (_data != nullptr)
+        munmap(const_cast<void*>(_data), _size); // NOLINT(*const-cast)
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+    unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& o) noexcept
+    : _data{std::exchange(o._data, nullptr)}
+    , _size{std::exchange(o._size, 0)}
+#if defined(_WIN32)
+    , _file{std::exchange(o._file, nullptr)}
+    , _mapping{std::exchange(o._mapping, nullptr)}
+#endif
+{}
+
+auto MappedFile::operator=(MappedFile&& o) noexcept -> MappedFile&
+{
+    if (this != &o)
+    {
+        unmap();
+        _data = std::exchange(o._data, nullptr);
+        _size = std::exchange(o._size, 0);
+#if defined(_WIN32)
+        _file    = std::exchange(o._file, nullptr);
+        _mapping = std::exchange(o._mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+} // namespace gl::internal
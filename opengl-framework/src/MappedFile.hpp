@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace gl::internal {
+
+/// Read-only view of a whole file, mapped in memory by the OS.
+class MappedFile {
+public:
+    explicit MappedFile(std::filesystem::path const& absolute_path);
+    ~MappedFile();
+    MappedFile(MappedFile const&)                    = delete;
+    auto operator=(MappedFile const&) -> MappedFile& = delete;
+    MappedFile(MappedFile&&) noexcept;
+    auto operator=(MappedFile&&) noexcept -> MappedFile&;
+
+    auto bytes() const -> std::span<std::byte const> { return {static_cast<std::byte const*>(_data), _size}; }
+
+private:
+    void unmap();
+
+private:
+    void const* _data{nullptr};
+    size_t      _size{0};
+#if defined(_WIN32)
+    void* _file{nullptr};
+    void* _mapping{nullptr};
+#endif
+};
+
+} // namespace gl::internal
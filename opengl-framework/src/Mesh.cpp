@@ -1,7 +1,10 @@
 #include "Mesh.hpp"
+#include <algorithm>
 #include <cassert>
 #include <numeric>
 #include <opengl-framework/opengl-framework.hpp>
+#include "StateCache.hpp"
+#include "gl_extensions.hpp"
 
 namespace gl {
 
@@ -17,87 +20,345 @@ static auto type(AnyVertexAttribute const& attr)
 {
     return std::visit([](auto&& attr) { return attr.type(); }, attr);
 }
+static auto normalized(AnyVertexAttribute const& attr)
+{
+    return std::visit([](auto&& attr) { return attr.normalized(); }, attr);
+}
 static auto size_in_bytes(AnyVertexAttribute const& attr)
 {
-    return size(attr) * 4;
+    return std::visit([](auto&& attr) { return attr.size_in_bytes(); }, attr);
+}
+static auto columns_count(AnyVertexAttribute const& attr)
+{
+    return std::visit([](auto&& attr) { return attr.columns_count(); }, attr);
+}
+
+auto vertex_stride(std::vector<AnyVertexAttribute> const& layout) -> GLsizei
+{
+    return std::accumulate(layout.begin(), layout.end(), 0, [](int acc, AnyVertexAttribute const& attr) {
+        return acc + size_in_bytes(attr);
+    });
+}
+
+namespace internal {
+
+void set_vertex_attributes(std::vector<AnyVertexAttribute> const& layout, GLuint divisor)
+{
+    int const stride = vertex_stride(layout);
+    uint64_t pointer{0};
+    for (auto const& attribute : layout)
+    {
+        auto const column_size = static_cast<uint64_t>(gl::size_in_bytes(attribute) / columns_count(attribute)); // Qualified, otherwise internal::size_in_bytes() would hide it
+        for (int column = 0; column < columns_count(attribute); ++column) // Matrices use one location per column
+        {
+            auto const location = static_cast<GLuint>(index(attribute) + column);
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, size(attribute), type(attribute), normalized(attribute), stride, reinterpret_cast<void*>(pointer)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+            glVertexAttribDivisor(location, divisor);
+            pointer += column_size;
+        }
+    }
+}
+
+void set_vertex_attributes(GLuint vertex_array, GLuint binding_index, GLuint buffer, std::vector<AnyVertexAttribute> const& layout, GLuint divisor)
+{
+    auto const& ext = gl_extensions();
+    ext.VertexArrayVertexBuffer(vertex_array, binding_index, buffer, 0, vertex_stride(layout));
+    ext.VertexArrayBindingDivisor(vertex_array, binding_index, divisor);
+    GLuint offset{0};
+    for (auto const& attribute : layout)
+    {
+        auto const column_size = static_cast<GLuint>(gl::size_in_bytes(attribute) / columns_count(attribute)); // Qualified, otherwise internal::size_in_bytes() would hide it
+        for (int column = 0; column < columns_count(attribute); ++column) // Matrices use one location per column
+        {
+            auto const location = static_cast<GLuint>(index(attribute) + column);
+            ext.EnableVertexArrayAttrib(vertex_array, location);
+            ext.VertexArrayAttribFormat(vertex_array, location, size(attribute), type(attribute), normalized(attribute), offset);
+            ext.VertexArrayAttribBinding(vertex_array, location, binding_index);
+            offset += column_size;
+        }
+    }
+}
+
+auto layouts_are_equal(std::vector<AnyVertexAttribute> const& a, std::vector<AnyVertexAttribute> const& b) -> bool
+{
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](AnyVertexAttribute const& attr_a, AnyVertexAttribute const& attr_b) {
+        return attr_a.index() == attr_b.index() // Same type of attribute
+               && index(attr_a) == index(attr_b);
+    });
+}
+
+} // namespace internal
+
+void Mesh::create_vertex_array()
+{
+    if (internal::supports_direct_state_access())
+    {
+        internal::gl_extensions().CreateVertexArrays(1, &_vertex_array);
+        return;
+    }
+    glGenVertexArrays(1, &_vertex_array);
+    StateCache::bind_vertex_array(_vertex_array);
+}
+
+static void create_buffers(GLsizei count, GLuint* buffers)
+{
+    if (internal::supports_direct_state_access())
+        internal::gl_extensions().CreateBuffers(count, buffers); // Unlike glGenBuffers(), this creates the objects right away, so that we can edit them without binding them
+    else
+        glGenBuffers(count, buffers);
+}
+
+void Mesh::create_vertex_buffers(size_t count)
+{
+    _vertex_buffers.resize(count);
+    create_buffers(static_cast<GLsizei>(_vertex_buffers.size()), _vertex_buffers.data());
+}
+
+void Mesh::upload_vertex_data(GLuint buffer_id, std::span<std::byte const> data)
+{
+    if (internal::supports_direct_state_access())
+    {
+        if (!data.empty()) // An immutable storage can't be empty
+            internal::gl_extensions().NamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(data.size()), data.data(), 0);
+        return;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(data.size()), data.data(), GL_STATIC_DRAW);
+}
+
+auto Mesh::upload_vertex_buffer(GLuint buffer_id, GLuint binding_index, std::vector<AnyVertexAttribute> const& layout, std::span<std::byte const> data) -> size_t
+{
+    upload_vertex_data(buffer_id, data);
+    if (internal::supports_direct_state_access())
+        internal::set_vertex_attributes(_vertex_array, binding_index, buffer_id, layout);
+    else
+        internal::set_vertex_attributes(layout);
+    return data.size() / static_cast<size_t>(vertex_stride(layout));
+}
+
+void Mesh::upload_index_buffer(std::span<uint32_t const> indices)
+{
+    assert(indices.size() % 3 == 0 && "You must provide 3 indices for each triangle");
+    _triangles_count = indices.size() / 3;
+    create_buffers(1, &_maybe_index_buffer);
+    if (internal::supports_direct_state_access())
+    {
+        internal::gl_extensions().NamedBufferStorage(_maybe_index_buffer, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(), 0);
+        internal::gl_extensions().VertexArrayElementBuffer(_vertex_array, _maybe_index_buffer);
+        return;
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _maybe_index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size_bytes()), indices.data(), GL_STATIC_DRAW);
+}
+
+static auto as_bytes_descriptors(std::vector<VertexBuffer_Descriptor> const& vertex_buffers) -> std::vector<VertexBufferBytes_Descriptor>
+{
+    auto res = std::vector<VertexBufferBytes_Descriptor>{};
+    res.reserve(vertex_buffers.size());
+    for (auto const& vertex_buffer : vertex_buffers)
+        res.push_back({.layout = vertex_buffer.layout, .data = std::as_bytes(std::span{vertex_buffer.data})});
+    return res;
 }
 
 Mesh::Mesh(Mesh_Descriptor desc)
+    : Mesh{MeshSpans_Descriptor{
+          .vertex_buffers = as_bytes_descriptors(desc.vertex_buffers), // Only references the data, which is not copied
+          .index_buffer   = desc.index_buffer,
+      }}
+{}
+
+Mesh::Mesh(MeshSpans_Descriptor const& desc)
 {
-    assert(!desc.vertex_buffers.empty() && "You must provide at least one vertex buffer to construct a mesh.");
+    upload(desc);
+}
 
-    if (!desc.index_buffer.empty())
+Mesh::Mesh(MeshBytes_Descriptor const& desc)
+{
+    if (desc.arena != nullptr)
     {
+        _arena_pool       = desc.arena->pool(desc.layout);
+        _arena_allocation = _arena_pool->allocate(desc.vertex_data, desc.index_buffer);
+        _vertex_array     = _arena_pool->vertex_array(); // Owned by the pool
         assert(desc.index_buffer.size() % 3 == 0 && "You must provide 3 indices for each triangle");
-        _triangles_count = desc.index_buffer.size() / 3;
+        _triangles_count = (desc.index_buffer.empty() ? _arena_allocation.vertices_count : _arena_allocation.indices_count) / 3;
+        set_submeshes(desc.submeshes);
+        return;
     }
 
-    { // Vertex Array
-        glGenVertexArrays(1, &_vertex_array);
-        glBindVertexArray(_vertex_array);
-    }
+    auto const vertex_buffer = VertexBufferBytes_Descriptor{.layout = desc.layout, .data = desc.vertex_data};
+    upload({
+        .vertex_buffers = {&vertex_buffer, 1},
+        .index_buffer   = desc.index_buffer,
+        .submeshes      = desc.submeshes,
+    });
+}
+
+void Mesh::upload(MeshSpans_Descriptor const& desc)
+{
+    assert(!desc.vertex_buffers.empty() && "You must provide at least one vertex buffer to construct a mesh.");
+
+    create_vertex_array();
 
     { // Vertex Buffers
-        _vertex_buffers.resize(desc.vertex_buffers.size());
-        glGenBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
+        create_vertex_buffers(desc.vertex_buffers.size());
         for (size_t i = 0; i < _vertex_buffers.size(); ++i)
         {
-            glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffers[i]);
-            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(desc.vertex_buffers[i].data.size() * sizeof(GLfloat)), desc.vertex_buffers[i].data.data(), GL_STATIC_DRAW);
-
-            int const stride = std::accumulate(desc.vertex_buffers[i].layout.begin(), desc.vertex_buffers[i].layout.end(), 0, [](int acc, AnyVertexAttribute const& attr) {
-                return acc + size_in_bytes(attr);
-            });
+            auto const vertices_count = upload_vertex_buffer(_vertex_buffers[i], static_cast<GLuint>(i), desc.vertex_buffers[i].layout, desc.vertex_buffers[i].data);
             if (desc.index_buffer.empty())
             {
-                auto const triangles_count = desc.vertex_buffers[i].data.size() / (stride / sizeof(float)) / 3;
+                auto const triangles_count = vertices_count / 3;
                 if (i == 0)
                     _triangles_count = triangles_count;
                 else
                     assert(_triangles_count == triangles_count && "Some vertex buffers contain more vertices than others! Make sure that their data is correct, and that the layout matches the data.");
             }
-            uint64_t pointer{0};
-            for (auto const& attribute : desc.vertex_buffers[i].layout)
-            {
-                glEnableVertexAttribArray(index(attribute));
-                glVertexAttribPointer(index(attribute), size(attribute), type(attribute), GL_FALSE, stride, reinterpret_cast<void*>(pointer)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
-                pointer += size_in_bytes(attribute);
-            }
         }
     }
 
-    { // Index Buffer
-        if (!desc.index_buffer.empty())
-        {
-            glGenBuffers(1, &_maybe_index_buffer);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _maybe_index_buffer);
-            glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(desc.index_buffer.size() * sizeof(uint32_t)), desc.index_buffer.data(), GL_STATIC_DRAW);
-        }
+    finish_upload(3 * _triangles_count, desc.index_buffer, desc.submeshes);
+}
+
+void Mesh::finish_upload(size_t vertices_count, std::span<uint32_t const> indices, std::span<Submesh const> submeshes)
+{
+    if (!indices.empty())
+        upload_index_buffer(indices);
+    else
+        _triangles_count = vertices_count / 3;
+    set_submeshes(submeshes);
+}
+
+void Mesh::set_submeshes(std::span<Submesh const> submeshes)
+{
+    if (submeshes.empty())
+    {
+        _submeshes = {Submesh{.range = {.first_index = 0, .indices_count = static_cast<uint32_t>(3 * _triangles_count)}}};
+        return;
     }
+    _submeshes.assign(submeshes.begin(), submeshes.end());
+    for ([[maybe_unused]] auto const& submesh : _submeshes)
+        assert(submesh.range.first_index + submesh.range.indices_count <= 3 * _triangles_count);
+}
+
+auto Mesh::has_index_buffer() const -> bool
+{
+    return _arena_pool ? _arena_allocation.indices_count != 0 : _maybe_index_buffer != 0;
 }
 
 void Mesh::draw() const
 {
-    glBindVertexArray(_vertex_array);
-    if (_maybe_index_buffer != 0)
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), GL_UNSIGNED_INT, reinterpret_cast<void*>(0)); // NOLINT(*reinterpret-cast)
+    StateCache::bind_vertex_array(_vertex_array);
+    issue_draw_call({.first_index = 0, .indices_count = static_cast<uint32_t>(3 * _triangles_count)});
+}
+
+void Mesh::draw_instanced(size_t instances_count) const
+{
+    StateCache::bind_vertex_array(_vertex_array);
+    if (has_index_buffer())
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(3 * _triangles_count), GL_UNSIGNED_INT, reinterpret_cast<void const*>(_arena_allocation.first_index * sizeof(uint32_t)), static_cast<GLsizei>(instances_count), static_cast<GLint>(_arena_allocation.first_vertex)); // NOLINT(*reinterpret-cast, *no-int-to-ptr)
     else
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(3 * _triangles_count));
+        glDrawArraysInstanced(GL_TRIANGLES, static_cast<GLint>(_arena_allocation.first_vertex), static_cast<GLsizei>(3 * _triangles_count), static_cast<GLsizei>(instances_count));
 }
 
-Mesh::~Mesh()
+void Mesh::set_instance_buffer(InstanceBuffer const& instance_buffer)
+{
+    assert(!_arena_pool && "set_instance_buffer() is not available for meshes that live in a MeshArena.");
+    if (internal::supports_direct_state_access())
+    {
+        internal::set_vertex_attributes(_vertex_array, static_cast<GLuint>(_vertex_buffers.size()), instance_buffer.id(), instance_buffer.layout(), 1); // The binding indices before that one are used by our vertex buffers
+        return;
+    }
+    StateCache::bind_vertex_array(_vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer.id());
+    internal::set_vertex_attributes(instance_buffer.layout(), 1);
+}
+
+void Mesh::draw_ranges(std::span<IndexRange const> ranges) const
 {
+    assert(has_index_buffer() && "draw_ranges() requires a mesh with an index buffer");
+
+    thread_local auto merged_ranges = std::vector<IndexRange>{};
+    thread_local auto counts        = std::vector<GLsizei>{};
+    thread_local auto offsets       = std::vector<void const*>{};
+    thread_local auto base_vertices = std::vector<GLint>{};
+    merged_ranges.clear();
+    for (auto const& range : ranges)
+    {
+        assert(range.first_index + range.indices_count <= 3 * _triangles_count);
+        if (!merged_ranges.empty() && merged_ranges.back().first_index + merged_ranges.back().indices_count == range.first_index)
+            merged_ranges.back().indices_count += range.indices_count; // Contiguous ranges can be drawn as one
+        else
+            merged_ranges.push_back(range);
+    }
+    if (merged_ranges.empty())
+        return;
+
+    counts.clear();
+    offsets.clear();
+    for (auto const& range : merged_ranges)
+    {
+        counts.push_back(static_cast<GLsizei>(range.indices_count));
+        offsets.push_back(reinterpret_cast<void const*>((_arena_allocation.first_index + range.first_index) * sizeof(uint32_t))); // NOLINT(*reinterpret-cast, *no-int-to-ptr)
+    }
+    base_vertices.assign(counts.size(), static_cast<GLint>(_arena_allocation.first_vertex));
+    StateCache::bind_vertex_array(_vertex_array);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(counts.size()), base_vertices.data());
+}
+
+void Mesh::draw_submesh(size_t submesh_index) const
+{
+    assert(submesh_index < _submeshes.size());
+    StateCache::bind_vertex_array(_vertex_array);
+    issue_draw_call(_submeshes[submesh_index].range);
+}
+
+void Mesh::draw_submeshes(std::function<void(Submesh const&)> const& before_draw) const
+{
+    StateCache::bind_vertex_array(_vertex_array);
+    for (auto const& submesh : _submeshes)
+    {
+        before_draw(submesh);
+        issue_draw_call(submesh.range);
+    }
+}
+
+void Mesh::issue_draw_call(IndexRange const& range) const
+{
+    // When the mesh lives in an arena, its indices and vertices don't start at the beginning of the buffers (otherwise the offsets are 0)
+    if (has_index_buffer())
+        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indices_count), GL_UNSIGNED_INT, reinterpret_cast<void const*>((_arena_allocation.first_index + range.first_index) * sizeof(uint32_t)), static_cast<GLint>(_arena_allocation.first_vertex)); // NOLINT(*reinterpret-cast, *no-int-to-ptr)
+    else
+        glDrawArrays(GL_TRIANGLES, static_cast<GLint>(_arena_allocation.first_vertex + range.first_index), static_cast<GLsizei>(range.indices_count));
+}
+
+void Mesh::release_gpu_resources()
+{
+    if (_arena_pool)
+    {
+        _arena_pool->free(_arena_allocation); // The vertex array and buffers belong to the pool
+        _arena_pool.reset();
+        return;
+    }
+    internal::state_cache_forget_vertex_array(_vertex_array);
     glDeleteVertexArrays(1, &_vertex_array);
     if (!_vertex_buffers.empty()) // Might have been moved-from
         glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
     glDeleteBuffers(1, &_maybe_index_buffer);
 }
 
+Mesh::~Mesh()
+{
+    release_gpu_resources();
+}
+
 Mesh::Mesh(Mesh&& o) noexcept
     : _vertex_array{o._vertex_array}
     , _vertex_buffers{std::move(o._vertex_buffers)}
     , _maybe_index_buffer{o._maybe_index_buffer}
     , _triangles_count{o._triangles_count}
+    , _submeshes{std::move(o._submeshes)}
+    , _arena_pool{std::move(o._arena_pool)}
+    , _arena_allocation{o._arena_allocation}
 {
     o._vertex_array = 0;
     o._vertex_buffers.resize(0);
@@ -109,16 +370,16 @@ auto Mesh::operator=(Mesh&& o) noexcept -> Mesh&
     if (this != &o)
     {
         // Delete this
-        glDeleteVertexArrays(1, &_vertex_array);
-        if (!_vertex_buffers.empty()) // Might have been moved-from
-            glDeleteBuffers(static_cast<int>(_vertex_buffers.size()), _vertex_buffers.data());
-        glDeleteBuffers(1, &_maybe_index_buffer);
+        release_gpu_resources();
 
         // Move
         _vertex_array       = o._vertex_array;
         _vertex_buffers     = std::move(o._vertex_buffers);
         _maybe_index_buffer = o._maybe_index_buffer;
         _triangles_count    = o._triangles_count;
+        _submeshes          = std::move(o._submeshes);
+        _arena_pool         = std::move(o._arena_pool);
+        _arena_allocation   = o._arena_allocation;
 
         o._vertex_array = 0;
         o._vertex_buffers.resize(0);
@@ -1,7 +1,16 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
 #include <variant>
 #include <vector>
+#include "gl_extensions.hpp"
 #include "glad/gl.h"
+#include "glm/glm.hpp"
 
 namespace gl {
 
@@ -13,6 +22,8 @@ public:
     {}
 
     auto index() const -> int { return _index; }
+    /// Number of consecutive locations used by the attribute (more than 1 for matrices).
+    static constexpr auto columns_count() -> GLint { return 1; }
 
 private:
     int _index{};
@@ -23,50 +34,159 @@ namespace VertexAttribute {
 class Float : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 1; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 1; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class Vec2 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 2; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class Vec3 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 3; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 3; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class Vec4 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 4; }
-    static auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class Int : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 1; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 1; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class IVec2 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 2; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class IVec3 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 3; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 3; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
 };
 class IVec4 : public internal::VertexAttribute_Base {
 public:
     using VertexAttribute_Base::VertexAttribute_Base;
-    static auto size() -> GLint { return 4; }
-    static auto type() -> GLenum { return GL_INT; }
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_INT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4 * size(); }
+};
+
+/// Half-precision floats. Good enough for UVs, and twice as small as floats.
+class Vec2_Half : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_HALF_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+class Vec4_Half : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_HALF_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+};
+/// Values in [0, 255] in the buffer, that the shader receives as floats in [0, 1].
+class Vec4_UNorm8 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_BYTE; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+/// Values in [-127, 127] in the buffer, that the shader receives as floats in [-1, 1].
+class Vec4_SNorm8 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_BYTE; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+/// Values in [0, 65535] in the buffer, that the shader receives as floats in [0, 1].
+class Vec2_UNorm16 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_UNSIGNED_SHORT; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+/// Values in [-32767, 32767] in the buffer, that the shader receives as floats in [-1, 1].
+class Vec2_SNorm16 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 2; }
+    static constexpr auto type() -> GLenum { return GL_SHORT; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+class Vec4_SNorm16 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_SHORT; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 8; }
+};
+/// x, y and z on 10 bits each, and w on 2 bits, all packed in a single 32-bit integer. The shader receives them as floats in [-1, 1].
+/// Typically used for normals (see glm::packSnorm3x10_1x2()).
+class Vec4_SNorm_2_10_10_10 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_INT_2_10_10_10_REV; }
+    static constexpr auto normalized() -> GLboolean { return GL_TRUE; }
+    static constexpr auto size_in_bytes() -> GLint { return 4; }
+};
+/// A whole matrix, typically used as a per-instance attribute (see InstanceBuffer). It uses 4 consecutive locations, one per column.
+class Mat4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 64; }
+    static constexpr auto columns_count() -> GLint { return 4; }
+};
+/// The first 3 rows of an affine transform (the last one is always 0 0 0 1), so it is 25% smaller than a Mat4. See pack_transform().
+/// In the shader, declare it as `in mat3x4 transform;` and use it as `vec3 position = vec4(in_position, 1.) * transform;`. It uses 3 consecutive locations.
+class Mat3x4 : public internal::VertexAttribute_Base {
+public:
+    using VertexAttribute_Base::VertexAttribute_Base;
+    static constexpr auto size() -> GLint { return 4; }
+    static constexpr auto type() -> GLenum { return GL_FLOAT; }
+    static constexpr auto normalized() -> GLboolean { return GL_FALSE; }
+    static constexpr auto size_in_bytes() -> GLint { return 48; }
+    static constexpr auto columns_count() -> GLint { return 3; }
 };
 
 using Position2D = Vec2;
@@ -75,6 +195,13 @@ using Normal3D   = Vec3;
 using UV         = Vec2;
 using ColorRGB   = Vec3;
 using ColorRGBA  = Vec4;
+
+using UV_Half         = Vec2_Half;
+using Normal3D_Packed = Vec4_SNorm_2_10_10_10;
+using ColorRGBA8      = Vec4_UNorm8;
+
+using Transform        = Mat4;
+using Transform_Packed = Mat3x4;
 } // namespace VertexAttribute
 
 using AnyVertexAttribute = std::variant<
@@ -85,7 +212,30 @@ using AnyVertexAttribute = std::variant<
     VertexAttribute::Int,
     VertexAttribute::IVec2,
     VertexAttribute::IVec3,
-    VertexAttribute::IVec4>;
+    VertexAttribute::IVec4,
+    VertexAttribute::Vec2_Half,
+    VertexAttribute::Vec4_Half,
+    VertexAttribute::Vec4_UNorm8,
+    VertexAttribute::Vec4_SNorm8,
+    VertexAttribute::Vec2_UNorm16,
+    VertexAttribute::Vec2_SNorm16,
+    VertexAttribute::Vec4_SNorm16,
+    VertexAttribute::Vec4_SNorm_2_10_10_10,
+    VertexAttribute::Mat4,
+    VertexAttribute::Mat3x4>;
+
+/// Size of one vertex, in bytes.
+auto vertex_stride(std::vector<AnyVertexAttribute> const& layout) -> GLsizei;
+
+namespace internal {
+/// Describes the layout to the currently bound vertex array, for the vertex buffer that is currently bound to GL_ARRAY_BUFFER.
+/// With a divisor of 1, the attributes advance once per instance instead of once per vertex.
+void set_vertex_attributes(std::vector<AnyVertexAttribute> const& layout, GLuint divisor = 0);
+/// Same, with Direct State Access: describes the layout of `buffer` to `vertex_array`, through the given binding index, without binding anything.
+void set_vertex_attributes(GLuint vertex_array, GLuint binding_index, GLuint buffer, std::vector<AnyVertexAttribute> const& layout, GLuint divisor = 0);
+/// True if both layouts have the same attributes, in the same order.
+auto layouts_are_equal(std::vector<AnyVertexAttribute> const&, std::vector<AnyVertexAttribute> const&) -> bool;
+} // namespace internal
 
 struct VertexBuffer_Descriptor {
     std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
@@ -97,9 +247,94 @@ struct Mesh_Descriptor {
     std::vector<uint32_t> const&                index_buffer{};
 };
 
+/// Same as VertexBuffer_Descriptor, but the data can live anywhere (e.g. in a memory-mapped file, or in the buffers of a parser), and is uploaded as is, without being copied into a std::vector first.
+struct VertexBufferBytes_Descriptor {
+    std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
+    std::span<std::byte const>             data{};
+};
+
+/// A range of consecutive triangles in the index buffer of a Mesh.
+struct IndexRange {
+    uint32_t first_index{};
+    uint32_t indices_count{};
+};
+
+/// As described in an .mtl file. The textures are not loaded, but you can use their path to load them yourself.
+struct Material {
+    std::string           name{};
+    glm::vec3             diffuse_color{1.f};
+    std::filesystem::path diffuse_texture{}; // Absolute path, empty if there is none
+};
+
+/// A part of a Mesh that uses a single material.
+struct Submesh {
+    IndexRange range{};
+    Material   material{};
+};
+
+class MeshArena;
+class InstanceBuffer;
+namespace internal {
+class MeshArenaPool;
+/// Where a mesh lives in the buffers of a MeshArena
+struct ArenaAllocation {
+    uint32_t first_vertex{};
+    uint32_t vertices_count{};
+    uint32_t first_index{};
+    uint32_t indices_count{};
+};
+} // namespace internal
+
+/// Same as Mesh_Descriptor, but nothing needs to be copied into a std::vector first: the data is uploaded straight from your memory.
+/// All the other descriptors end up being converted to this one.
+struct MeshSpans_Descriptor {
+    std::span<VertexBufferBytes_Descriptor const> vertex_buffers{};
+    std::span<uint32_t const>                     index_buffer{};
+    /// If empty, the whole mesh is considered as one single submesh.
+    std::span<Submesh const>                      submeshes{};
+};
+
+/// For a Mesh whose layout is known at compile time (see VertexLayout).
+template<typename Vertex>
+struct TypedMesh_Descriptor {
+    std::span<Vertex const>   vertices{};
+    std::span<uint32_t const> index_buffer{};
+    /// If empty, the whole mesh is considered as one single submesh.
+    std::span<Submesh const>  submeshes{};
+};
+
+/// Same as MeshSpans_Descriptor, for the common case of a single interleaved vertex buffer.
+struct MeshBytes_Descriptor {
+    std::vector<AnyVertexAttribute> const& layout; // NOLINT(*avoid-const-or-ref-data-members)
+    std::span<std::byte const>             vertex_data{};
+    std::span<uint32_t const>              index_buffer{};
+    /// If empty, the whole mesh is considered as one single submesh.
+    std::span<Submesh const>               submeshes{};
+    /// If set, the mesh is stored in the shared buffers of the arena, instead of having its own vertex array and buffers. See MeshArena.
+    MeshArena* arena{nullptr};
+};
+
 class Mesh {
 public:
     explicit Mesh(Mesh_Descriptor);
+    explicit Mesh(MeshSpans_Descriptor const&);
+    explicit Mesh(MeshBytes_Descriptor const&);
+    /// e.g. `gl::Mesh{gl::VertexLayout<gl::VertexAttribute::Position3D, gl::VertexAttribute::UV>{}, gl::TypedMesh_Descriptor<MyVertex>{.vertices = vertices}}`.
+    /// The layout is set up without going through any std::variant nor any allocation, and a vertex struct that doesn't match the layout is a compile error.
+    /// Only the layout side is allocation-free: like the other constructors, the Mesh still allocates the (small) lists of its buffers and of its submeshes.
+    template<typename Layout, typename Vertex>
+    Mesh(Layout, TypedMesh_Descriptor<Vertex> const& desc)
+    {
+        static_assert(Layout::template matches<Vertex>, "The size of your vertex struct doesn't match the layout (or your struct is not trivially copyable).");
+        create_vertex_array();
+        create_vertex_buffers(1);
+        upload_vertex_data(_vertex_buffers[0], std::as_bytes(desc.vertices));
+        if (internal::supports_direct_state_access())
+            Layout::set_vertex_attributes(_vertex_array, 0, _vertex_buffers[0]);
+        else
+            Layout::set_vertex_attributes(); // upload_vertex_data() left the buffer bound to GL_ARRAY_BUFFER
+        finish_upload(desc.vertices.size(), desc.index_buffer, desc.submeshes);
+    }
     ~Mesh();
     Mesh(Mesh const&)                    = delete; // You cannot copy
     auto operator=(Mesh const&) -> Mesh& = delete; // a Mesh. But you can move it, using std::move(my_mesh)
@@ -107,13 +342,48 @@ public:
     auto operator=(Mesh&&) noexcept -> Mesh&;
 
     void draw() const;
+    /// Draws the mesh `instances_count` times in a single draw call. Use gl_InstanceID, or the attributes of the instance buffer, to make each instance different.
+    void draw_instanced(size_t instances_count) const;
+    /// Plugs the per-instance attributes of the buffer into the vertex array of the mesh. You only need to do it once, even if the content of the buffer changes later.
+    /// Not available for meshes that live in a MeshArena, because they share their vertex array with other meshes.
+    void set_instance_buffer(InstanceBuffer const&);
+    /// Only draws some parts of the mesh, in a single draw call. The mesh must have an index buffer.
+    void draw_ranges(std::span<IndexRange const>) const;
+
+    /// There is always at least one submesh.
+    auto submeshes() const -> std::vector<Submesh> const& { return _submeshes; }
+    void draw_submesh(size_t submesh_index) const;
+    /// Draws all the submeshes one after the other, and calls `before_draw` before each one so that you can set the uniforms of its material.
+    /// This only binds the vertex array once, which is cheaper than having one Mesh per material.
+    void draw_submeshes(std::function<void(Submesh const&)> const& before_draw) const;
+
+private:
+    void create_vertex_array();
+    void create_vertex_buffers(size_t count);
+    void upload(MeshSpans_Descriptor const&);
+    /// Uploads the index buffer (if any) and sets the submeshes, once the vertex buffers have been uploaded.
+    void finish_upload(size_t vertices_count, std::span<uint32_t const> indices, std::span<Submesh const> submeshes);
+    /// Returns the number of vertices in the buffer
+    auto upload_vertex_buffer(GLuint buffer_id, GLuint binding_index, std::vector<AnyVertexAttribute> const& layout, std::span<std::byte const> data) -> size_t;
+    /// Without Direct State Access, this leaves the buffer bound to GL_ARRAY_BUFFER.
+    void upload_vertex_data(GLuint buffer_id, std::span<std::byte const> data);
+    void upload_index_buffer(std::span<uint32_t const> indices);
+    void set_submeshes(std::span<Submesh const>);
+    auto has_index_buffer() const -> bool;
+    void release_gpu_resources();
+    /// Assumes that the vertex array is already bound
+    void issue_draw_call(IndexRange const&) const;
 
 private:
     GLuint              _vertex_array{};
     std::vector<GLuint> _vertex_buffers{};
     GLuint              _maybe_index_buffer{};
 
-    size_t _triangles_count{};
+    size_t               _triangles_count{};
+    std::vector<Submesh> _submeshes{};
+
+    std::shared_ptr<internal::MeshArenaPool> _arena_pool{}; // Only set if the mesh lives in a MeshArena
+    internal::ArenaAllocation                _arena_allocation{};
 };
 
 } // namespace gl
\ No newline at end of file
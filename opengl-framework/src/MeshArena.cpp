@@ -0,0 +1,198 @@
+#include "MeshArena.hpp"
+#include <cassert>
+#include <iterator>
+#include "StateCache.hpp"
+#include "grow_buffer.hpp"
+
+namespace gl {
+
+namespace internal {
+
+FreeListAllocator::FreeListAllocator(size_t capacity)
+    : _capacity{capacity}
+{
+    if (capacity > 0)
+        _free_ranges[0] = capacity;
+}
+
+auto FreeListAllocator::allocate(size_t size) -> std::optional<size_t>
+{
+    if (size == 0)
+        return 0;
+    for (auto it = _free_ranges.begin(); it != _free_ranges.end(); ++it)
+    {
+        auto const [offset, free_size] = *it;
+        if (free_size < size)
+            continue;
+        _free_ranges.erase(it);
+        if (free_size > size)
+            _free_ranges[offset + size] = free_size - size;
+        _used_size += size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void FreeListAllocator::free(size_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+    assert(offset + size <= _capacity);
+    _used_size -= size;
+
+    auto it = _free_ranges.emplace(offset, size).first;
+    // Merge with the next range
+    auto const next = std::next(it);
+    if (next != _free_ranges.end() && offset + size == next->first)
+    {
+        it->second += next->second;
+        _free_ranges.erase(next);
+    }
+    // Merge with the previous range
+    if (it != _free_ranges.begin())
+    {
+        auto const previous = std::prev(it);
+        if (previous->first + previous->second == offset)
+        {
+            previous->second += it->second;
+            _free_ranges.erase(it);
+        }
+    }
+}
+
+void FreeListAllocator::grow(size_t new_capacity)
+{
+    assert(new_capacity >= _capacity);
+    auto const old_capacity = _capacity;
+    _capacity               = new_capacity;
+    _used_size += new_capacity - old_capacity; // free() will remove it
+    free(old_capacity, new_capacity - old_capacity);
+}
+
+MeshArenaPool::MeshArenaPool(std::vector<AnyVertexAttribute> layout, size_t initial_vertices_count, size_t initial_indices_count)
+    : _layout{std::move(layout)}
+    , _stride{static_cast<size_t>(vertex_stride(_layout))}
+    , _vertices{initial_vertices_count}
+    , _indices{initial_indices_count}
+{
+    glGenVertexArrays(1, &_vertex_array);
+    glGenBuffers(1, &_vertex_buffer);
+    glGenBuffers(1, &_index_buffer);
+
+    StateCache::bind_vertex_array(_vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(initial_vertices_count * _stride), nullptr, GL_STATIC_DRAW);
+    internal::set_vertex_attributes(_layout);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(initial_indices_count * sizeof(uint32_t)), nullptr, GL_STATIC_DRAW);
+}
+
+MeshArenaPool::~MeshArenaPool()
+{
+    internal::state_cache_forget_vertex_array(_vertex_array);
+    glDeleteVertexArrays(1, &_vertex_array);
+    glDeleteBuffers(1, &_vertex_buffer);
+    glDeleteBuffers(1, &_index_buffer);
+}
+
+auto MeshArenaPool::allocate(std::span<std::byte const> vertex_data, std::span<uint32_t const> indices) -> ArenaAllocation
+{
+    assert(vertex_data.size() % _stride == 0 && "The size of the vertex data doesn't match the layout.");
+    auto const vertices_count = vertex_data.size() / _stride;
+
+    auto first_vertex = _vertices.allocate(vertices_count);
+    if (!first_vertex)
+    {
+        auto const new_capacity = grown_capacity(_vertices.capacity(), _vertices.capacity() + vertices_count);
+        grow_buffer(_vertex_buffer, _vertices.capacity() * _stride, new_capacity * _stride);
+        _vertices.grow(new_capacity);
+        first_vertex = _vertices.allocate(vertices_count);
+        StateCache::bind_vertex_array(_vertex_array);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertex_buffer);
+        internal::set_vertex_attributes(_layout); // The vertex array needs to point to the new buffer
+    }
+    auto first_index = _indices.allocate(indices.size());
+    if (!first_index)
+    {
+        auto const new_capacity = grown_capacity(_indices.capacity(), _indices.capacity() + indices.size());
+        grow_buffer(_index_buffer, _indices.capacity() * sizeof(uint32_t), new_capacity * sizeof(uint32_t));
+        _indices.grow(new_capacity);
+        first_index = _indices.allocate(indices.size());
+        StateCache::bind_vertex_array(_vertex_array);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _index_buffer);
+    }
+    assert(first_vertex && first_index);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _vertex_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(*first_vertex * _stride), static_cast<GLsizeiptr>(vertex_data.size()), vertex_data.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _index_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(*first_index * sizeof(uint32_t)), static_cast<GLsizeiptr>(indices.size_bytes()), indices.data());
+
+    return ArenaAllocation{
+        .first_vertex   = static_cast<uint32_t>(*first_vertex),
+        .vertices_count = static_cast<uint32_t>(vertices_count),
+        .first_index    = static_cast<uint32_t>(*first_index),
+        .indices_count  = static_cast<uint32_t>(indices.size()),
+    };
+}
+
+void MeshArenaPool::free(ArenaAllocation const& allocation)
+{
+    _vertices.free(allocation.first_vertex, allocation.vertices_count);
+    _indices.free(allocation.first_index, allocation.indices_count);
+}
+
+auto MeshArenaPool::used_bytes() const -> size_t
+{
+    return _vertices.used_size() * _stride + _indices.used_size() * sizeof(uint32_t);
+}
+
+auto MeshArenaPool::capacity_in_bytes() const -> size_t
+{
+    return _vertices.capacity() * _stride + _indices.capacity() * sizeof(uint32_t);
+}
+
+} // namespace internal
+
+MeshArena::MeshArena(MeshArena_Descriptor const& desc)
+    : _desc{desc}
+{}
+
+auto MeshArena::create_mesh(MeshData const& data) -> Mesh
+{
+    return Mesh{MeshBytes_Descriptor{
+        .layout       = data.layout,
+        .vertex_data  = data.vertices,
+        .index_buffer = data.indices,
+        .submeshes    = data.submeshes,
+        .arena        = this,
+    }};
+}
+
+auto MeshArena::pool(std::vector<AnyVertexAttribute> const& layout) -> std::shared_ptr<internal::MeshArenaPool>
+{
+    for (auto const& pool : _pools)
+    {
+        if (internal::layouts_are_equal(pool->layout(), layout))
+            return pool;
+    }
+    return _pools.emplace_back(std::make_shared<internal::MeshArenaPool>(layout, _desc.initial_vertices_count, _desc.initial_indices_count));
+}
+
+auto MeshArena::used_bytes() const -> size_t
+{
+    size_t total = 0;
+    for (auto const& pool : _pools)
+        total += pool->used_bytes();
+    return total;
+}
+
+auto MeshArena::capacity_in_bytes() const -> size_t
+{
+    size_t total = 0;
+    for (auto const& pool : _pools)
+        total += pool->capacity_in_bytes();
+    return total;
+}
+
+} // namespace gl
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+namespace internal {
+
+/// Hands out ranges of [0, capacity). Picks the first free range that is big enough, and merges neighbouring ranges when they are freed.
+class FreeListAllocator {
+public:
+    explicit FreeListAllocator(size_t capacity);
+
+    /// Returns the offset of the allocated range, or nullopt if there is no free range big enough.
+    auto allocate(size_t size) -> std::optional<size_t>;
+    void free(size_t offset, size_t size);
+    void grow(size_t new_capacity);
+
+    auto capacity() const -> size_t { return _capacity; }
+    auto used_size() const -> size_t { return _used_size; }
+
+private:
+    std::map<size_t, size_t> _free_ranges{}; // Offset -> size
+    size_t                   _capacity;
+    size_t                   _used_size{};
+};
+
+/// All the meshes of an arena that have the same layout share one vertex array, one vertex buffer and one index buffer.
+class MeshArenaPool {
+public:
+    MeshArenaPool(std::vector<AnyVertexAttribute> layout, size_t initial_vertices_count, size_t initial_indices_count);
+    ~MeshArenaPool();
+    MeshArenaPool(MeshArenaPool const&)                    = delete;
+    auto operator=(MeshArenaPool const&) -> MeshArenaPool& = delete;
+    MeshArenaPool(MeshArenaPool&&)                         = delete;
+    auto operator=(MeshArenaPool&&) -> MeshArenaPool&      = delete;
+
+    auto allocate(std::span<std::byte const> vertex_data, std::span<uint32_t const> indices) -> ArenaAllocation;
+    void free(ArenaAllocation const&);
+
+    auto layout() const -> std::vector<AnyVertexAttribute> const& { return _layout; }
+    auto vertex_array() const -> GLuint { return _vertex_array; }
+    auto used_bytes() const -> size_t;
+    auto capacity_in_bytes() const -> size_t;
+
+private:
+    std::vector<AnyVertexAttribute> _layout;
+    size_t                          _stride;
+    GLuint                          _vertex_array{};
+    GLuint                          _vertex_buffer{};
+    GLuint                          _index_buffer{};
+    FreeListAllocator               _vertices; // In number of vertices
+    FreeListAllocator               _indices;  // In number of indices
+};
+
+} // namespace internal
+
+struct MeshArena_Descriptor {
+    /// The buffers grow automatically when they are full, but each growth copies the whole buffer, so it's better to start with a size close to what you need.
+    size_t initial_vertices_count{65'536};
+    size_t initial_indices_count{262'144};
+};
+
+/// Big shared buffers that many meshes can live in, instead of each one having its own vertex array and buffers.
+/// This reduces the number of OpenGL objects, and the state changes between two draws of meshes that have the same layout.
+/// Very useful when you have thousands of small meshes. Use it through MeshBytes_Descriptor::arena, or create_mesh().
+/// The meshes can outlive the arena: the buffers are only destroyed once all their meshes have been destroyed.
+class MeshArena {
+public:
+    explicit MeshArena(MeshArena_Descriptor const& = {});
+
+    /// Same as `Mesh{MeshBytes_Descriptor{...}}`, but stores the mesh in the arena.
+    auto create_mesh(MeshData const&) -> Mesh;
+
+    /// The pool for this layout is created the first time a mesh with that layout is added.
+    auto pool(std::vector<AnyVertexAttribute> const& layout) -> std::shared_ptr<internal::MeshArenaPool>;
+
+    /// Number of vertex arrays (one per layout)
+    auto pools_count() const -> size_t { return _pools.size(); }
+    auto used_bytes() const -> size_t;
+    auto capacity_in_bytes() const -> size_t;
+
+private:
+    MeshArena_Descriptor                                  _desc;
+    std::vector<std::shared_ptr<internal::MeshArenaPool>> _pools{};
+};
+
+} // namespace gl
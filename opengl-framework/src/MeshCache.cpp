@@ -0,0 +1,113 @@
+#include "MeshCache.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "handle_error.hpp"
+#include "hash.hpp"
+#include "load_obj.hpp"
+#include "make_absolute_path.hpp"
+
+namespace gl {
+
+/// Returns nullopt if the file can't be read
+static auto hash_file_content(std::filesystem::path const& path) -> std::optional<uint64_t>
+{
+    auto ifs = std::ifstream{path, std::ios::binary};
+    if (!ifs)
+        return std::nullopt;
+    auto const content = std::vector<char>{std::istreambuf_iterator<char>{ifs}, {}};
+    return internal::hash_bytes(std::as_bytes(std::span{content}));
+}
+
+/// Returns nullopt if the file doesn't exist
+static auto modification_time(std::filesystem::path const& path) -> std::optional<std::filesystem::file_time_type>
+{
+    auto       error = std::error_code{};
+    auto const time  = std::filesystem::last_write_time(path, error);
+    if (error)
+        return std::nullopt;
+    return time;
+}
+
+auto MeshCache::KeyHash::operator()(Key const& key) const noexcept -> size_t
+{
+    uint64_t hash = std::filesystem::hash_value(key.absolute_path);
+    hash          = internal::hash_combine(hash, static_cast<uint64_t>(key.last_write_time.time_since_epoch().count()));
+    return static_cast<size_t>(hash);
+}
+
+MeshCache::MeshCache()
+    : MeshCache{[](std::filesystem::path const& path) { return load_obj(path); }}
+{}
+
+MeshCache::MeshCache(std::function<Mesh(std::filesystem::path const&)> load_mesh)
+    : _load_mesh{std::move(load_mesh)}
+{}
+
+auto MeshCache::load_if_needed(Key const& key) -> bool
+{
+    if (_meshes.contains(key))
+        return false;
+    _stats.misses++;
+    _meshes.emplace(key, std::make_shared<Mesh const>(_load_mesh(key.absolute_path)));
+    return true;
+}
+
+auto MeshCache::get(std::filesystem::path const& path) -> std::shared_ptr<Mesh const>
+{
+    auto const it = _entries.find(path);
+    if (it != _entries.end())
+    {
+        _stats.hits++;
+        return _meshes.at(it->second.key);
+    }
+
+    auto const absolute_path = make_absolute_path(path).lexically_normal(); // So that the different paths to the same file share their mesh
+    auto const time          = modification_time(absolute_path);
+    if (!time)
+        handle_error(std::format("Failed to open file \"{}\".", absolute_path.string()));
+    auto const key = Key{.absolute_path = absolute_path, .last_write_time = *time};
+    if (!load_if_needed(key)) // The same file has already been loaded through another path
+        _stats.hits++;
+    _entries.emplace(path, Entry{.key = key});
+    return _meshes.at(key);
+}
+
+void MeshCache::reload_modified_files()
+{
+    for (auto& [path, entry] : _entries)
+    {
+        auto const time = modification_time(entry.key.absolute_path);
+        if (!time || *time == entry.key.last_write_time) // A missing file is skipped, it might only be missing for a moment while an editor is saving it
+            continue;
+        auto const content_hash = hash_file_content(entry.key.absolute_path);
+        if (!content_hash)
+            continue;
+
+        auto const new_key = Key{.absolute_path = entry.key.absolute_path, .last_write_time = *time};
+        if (content_hash == entry.content_hash) // The file has been touched, but its content didn't change, so no need to reload it
+            _meshes.try_emplace(new_key, _meshes.at(entry.key));
+        else
+            load_if_needed(new_key);
+        entry = Entry{.key = new_key, .content_hash = content_hash};
+    }
+    remove_unused_meshes();
+}
+
+void MeshCache::remove_unused_meshes()
+{
+    std::erase_if(_meshes, [&](auto const& kv) {
+        return std::none_of(_entries.begin(), _entries.end(), [&](auto const& path_and_entry) {
+            return path_and_entry.second.key == kv.first;
+        });
+    });
+}
+
+void MeshCache::clear()
+{
+    _entries.clear();
+    _meshes.clear();
+}
+
+} // namespace gl
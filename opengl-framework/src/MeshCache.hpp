@@ -0,0 +1,70 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include "Mesh.hpp"
+
+namespace gl {
+
+struct MeshCache_Stats {
+    uint64_t hits{};   /// Number of calls to get() that returned a mesh that was already loaded
+    uint64_t misses{}; /// Number of times a mesh had to be loaded (by get() or by reload_modified_files())
+};
+
+/// Loads each mesh file only once, and then hands out shared handles to it.
+/// Use it instead of loading your meshes inside your rendering loop.
+class MeshCache {
+public:
+    /// Uses load_obj() to load the meshes.
+    MeshCache();
+    /// `load_mesh` will be called with an absolute path each time a file needs to be (re)loaded.
+    explicit MeshCache(std::function<Mesh(std::filesystem::path const&)> load_mesh);
+
+    /// The file is only loaded the first time you request it. All subsequent calls are just a lookup in a hash map.
+    auto get(std::filesystem::path const& path) -> std::shared_ptr<Mesh const>;
+
+    /// Reloads all the files whose content has changed on disk since they were loaded.
+    /// Handles that were obtained before the reload stay valid, but keep pointing to the old version of the mesh.
+    /// Files that are missing are skipped, and checked again on the next call (editors often save a file by deleting it and renaming a temporary file).
+    void reload_modified_files();
+
+    /// Handles that were obtained before the clear stay valid.
+    void clear();
+
+    auto stats() const -> MeshCache_Stats const& { return _stats; }
+    void reset_stats() { _stats = {}; }
+
+private:
+    struct Key {
+        std::filesystem::path           absolute_path{};
+        std::filesystem::file_time_type last_write_time{};
+
+        friend auto operator==(Key const&, Key const&) -> bool = default;
+    };
+    struct Entry {
+        Key key{};
+        /// Only computed once the file has been modified, so that loading a file only reads it once. It then tells us if the next modifications actually changed the content.
+        std::optional<uint64_t> content_hash{};
+    };
+    struct KeyHash {
+        auto operator()(Key const&) const noexcept -> size_t;
+    };
+    struct PathHash {
+        auto operator()(std::filesystem::path const& path) const noexcept -> size_t { return std::filesystem::hash_value(path); }
+    };
+
+    /// Returns false if the mesh was already loaded (e.g. through another path to the same file).
+    auto load_if_needed(Key const&) -> bool;
+    void remove_unused_meshes();
+
+private:
+    std::function<Mesh(std::filesystem::path const&)>             _load_mesh;
+    std::unordered_map<Key, std::shared_ptr<Mesh const>, KeyHash> _meshes{};
+    std::unordered_map<std::filesystem::path, Entry, PathHash>    _entries{}; // Indexed by the path as given by the user, so that a lookup doesn't need to touch the disk
+    MeshCache_Stats                                               _stats{};
+};
+
+} // namespace gl
@@ -0,0 +1,31 @@
+#include "MeshData.hpp"
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace gl {
+
+auto MeshData::position(size_t vertex_index) const -> glm::vec3
+{
+    assert(!layout.empty() && std::holds_alternative<VertexAttribute::Position3D>(layout[0]));
+    auto position = glm::vec3{};
+    std::memcpy(&position, &vertices[vertex_index * vertex_stride()], sizeof(position));
+    return position;
+}
+
+auto MeshData::bounding_box() const -> BoundingBox
+{
+    if (vertices.empty())
+        return {};
+
+    auto bbox = BoundingBox{.min = glm::vec3{std::numeric_limits<float>::max()}, .max = glm::vec3{std::numeric_limits<float>::lowest()}};
+    for (size_t i = 0; i < vertices_count(); ++i)
+    {
+        auto const position = this->position(i);
+        bbox.min            = glm::min(bbox.min, position);
+        bbox.max            = glm::max(bbox.max, position);
+    }
+    return bbox;
+}
+
+} // namespace gl
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Mesh.hpp"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+struct BoundingBox {
+    glm::vec3 min{0.f};
+    glm::vec3 max{0.f};
+};
+
+/// CPU-side version of a Mesh: a single interleaved vertex buffer, and an index buffer.
+struct MeshData {
+    std::vector<AnyVertexAttribute> layout{};
+    std::vector<std::byte>          vertices{}; /// Interleaved, as described by the layout. The attributes can be of any type (float, half float, normalized integers, etc.)
+    std::vector<uint32_t>           indices{};
+    std::vector<Submesh>            submeshes{}; /// Ranges of the index buffer that use different materials. If empty, the whole mesh is considered as one single submesh.
+
+    /// Size of one vertex, in bytes
+    auto vertex_stride() const -> size_t { return static_cast<size_t>(gl::vertex_stride(layout)); }
+    auto vertices_count() const -> size_t { return vertices.size() / vertex_stride(); }
+    /// Assumes that the first attribute in the layout is a Position3D.
+    auto position(size_t vertex_index) const -> glm::vec3;
+    /// Assumes that the first attribute in the layout is a Position3D.
+    auto bounding_box() const -> BoundingBox;
+};
+
+} // namespace gl
@@ -0,0 +1,180 @@
+#include "ProgramBinaryCache.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "Shader.hpp"
+#include "exe_path/exe_path.h"
+#include "hash.hpp"
+
+namespace gl {
+
+namespace {
+
+// Must be incremented every time the format changes
+constexpr uint32_t format_version = 2;
+constexpr auto     magic          = std::array<char, 4>{'G', 'L', 'P', 'B'};
+
+struct Header {
+    std::array<char, 4> magic{};
+    uint32_t            version{};
+    uint64_t            key{};
+    uint64_t            check_hash{};
+    uint64_t            sources_size{};
+    uint32_t            binary_format{}; // As returned by glGetProgramBinary()
+    uint32_t            binary_size{};   // In bytes, the binary follows the header
+};
+
+auto cache_folder() -> std::filesystem::path&
+{
+    static auto instance = exe_path::dir() / "shader_cache";
+    return instance;
+}
+
+auto supported_binary_formats() -> std::vector<GLenum> const&
+{
+    static auto const formats = [] {
+        GLint formats_count{};
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats_count);
+        auto result = std::vector<GLint>(static_cast<size_t>(formats_count));
+        glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, result.data());
+        return std::vector<GLenum>{result.begin(), result.end()};
+    }();
+    return formats;
+}
+
+auto is_enabled() -> bool
+{
+    return !cache_folder().empty() && !supported_binary_formats().empty();
+}
+
+auto binary_path(uint64_t key) -> std::filesystem::path
+{
+    return cache_folder() / std::format("{:016x}.glprogram", key);
+}
+
+auto driver_hash(uint64_t seed) -> uint64_t
+{
+    auto result = seed;
+    for (GLenum const name : std::array<GLenum, 3>{GL_VENDOR, GL_RENDERER, GL_VERSION})
+        result = internal::hash_string(reinterpret_cast<char const*>(glGetString(name)), result); // NOLINT(*reinterpret-cast)
+    return result;
+}
+
+// The check hash uses another seed, and mixes the values in another way, so that it doesn't collide at the same time as the main hash
+constexpr uint64_t check_hash_seed = 0x6a09e667f3bcc908ull;
+
+} // namespace
+
+void set_shader_binary_cache_folder(std::filesystem::path folder)
+{
+    cache_folder() = std::move(folder);
+}
+
+namespace internal {
+
+auto program_binary_key(std::span<ShaderStageSource const> stages) -> ProgramBinaryKey
+{
+    static auto const driver_hashes = std::array<uint64_t, 2>{driver_hash(14695981039346656037ull), driver_hash(check_hash_seed)};
+
+    auto key = ProgramBinaryKey{.hash = driver_hashes[0], .check_hash = driver_hashes[1]};
+    for (auto const& stage : stages)
+    {
+        key.hash       = hash_combine(key.hash, stage.stage);
+        key.hash       = hash_string(stage.code, key.hash);
+        key.check_hash = hash_string(stage.code, key.check_hash ^ (uint64_t{stage.stage} << 32 | stage.code.size()));
+        key.sources_size += stage.code.size();
+    }
+    return key;
+}
+
+void prepare_program_for_binary_cache(GLuint program)
+{
+    if (is_enabled())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+auto load_program_binary(GLuint program, ProgramBinaryKey const& key) -> bool
+{
+    if (!is_enabled())
+        return false;
+
+    auto const path = binary_path(key.hash);
+    auto       ifs  = std::ifstream{path, std::ios::binary};
+    if (!ifs)
+        return false;
+    auto const content = std::vector<char>{std::istreambuf_iterator<char>{ifs}, {}};
+    if (content.size() < sizeof(Header))
+        return false;
+    auto header = Header{};
+    std::memcpy(&header, content.data(), sizeof(Header));
+    if (header.magic != magic || header.version != format_version
+        || header.key != key.hash || header.check_hash != key.check_hash || header.sources_size != key.sources_size
+        || content.size() != sizeof(Header) + header.binary_size)
+        return false;
+    if (std::find(supported_binary_formats().begin(), supported_binary_formats().end(), header.binary_format) == supported_binary_formats().end()) // glProgramBinary() would generate an error
+        return false;
+
+    glProgramBinary(program, header.binary_format, content.data() + sizeof(Header), static_cast<GLsizei>(header.binary_size)); // NOLINT(*pointer-arithmetic)
+    GLint link_status{};
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    if (link_status == GL_FALSE)
+    {
+        // Can happen even if the driver hasn't changed, e.g. if the binary depends on some state that has changed since it was saved. We will compile and save it again.
+        auto error = std::error_code{};
+        std::filesystem::remove(path, error);
+        return false;
+    }
+    return true;
+}
+
+void save_program_binary(GLuint program, ProgramBinaryKey const& key)
+{
+    if (!is_enabled())
+        return;
+
+    GLint binary_size{};
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_size);
+    if (binary_size <= 0)
+        return;
+    auto binary        = std::vector<char>(static_cast<size_t>(binary_size));
+    auto binary_format = GLenum{};
+    glGetProgramBinary(program, binary_size, nullptr, &binary_format, binary.data());
+
+    auto const header = Header{
+        .magic         = magic,
+        .version       = format_version,
+        .key           = key.hash,
+        .check_hash    = key.check_hash,
+        .sources_size  = key.sources_size,
+        .binary_format = binary_format,
+        .binary_size   = static_cast<uint32_t>(binary.size()),
+    };
+
+    auto const path  = binary_path(key.hash);
+    auto       error = std::error_code{};
+    std::filesystem::create_directories(cache_folder(), error);
+
+    // Write to a temporary file first, so that another process never sees a half-written binary
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        auto ofs = std::ofstream{tmp_path, std::ios::binary | std::ios::trunc};
+        ofs.write(reinterpret_cast<char const*>(&header), sizeof(header)); // NOLINT(*reinterpret-cast)
+        ofs.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!ofs)
+        {
+            std::cerr << std::format("[opengl_framework] Failed to write the shader binary \"{}\".\n", path.string());
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, error);
+}
+
+} // namespace internal
+
+} // namespace gl
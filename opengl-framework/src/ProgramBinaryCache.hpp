@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include "glad/gl.h"
+
+namespace gl::internal {
+
+struct ShaderStageSource {
+    GLenum      stage{}; // e.g. GL_VERTEX_SHADER
+    std::string code{};
+};
+
+/// Identifies a program: the code of all its stages (after preprocessing, so that the defines are taken into account), and the driver it was compiled by.
+/// A binary is only valid for the exact driver that produced it, so updating the driver or changing GPU automatically invalidates the cache.
+struct ProgramBinaryKey {
+    uint64_t hash{}; // Names the file
+    /// A wrong binary would link just fine and silently run the wrong code, so a collision of `hash` alone must not be enough to load it.
+    uint64_t check_hash{};   // Computed independently of `hash`
+    uint64_t sources_size{}; // Total size of the code of all the stages, in bytes
+
+    friend auto operator==(ProgramBinaryKey const&, ProgramBinaryKey const&) -> bool = default;
+};
+struct ProgramBinaryKeyHash {
+    auto operator()(ProgramBinaryKey const& key) const noexcept -> size_t { return static_cast<size_t>(key.hash); }
+};
+
+auto program_binary_key(std::span<ShaderStageSource const> stages) -> ProgramBinaryKey;
+
+/// Returns false if the cache is disabled, there is no binary for this key, or the driver rejected it. In that case you must compile the program from source.
+auto load_program_binary(GLuint program, ProgramBinaryKey const& key) -> bool;
+/// The program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set to GL_TRUE.
+void save_program_binary(GLuint program, ProgramBinaryKey const& key);
+/// Must be called before linking a program that we will save with save_program_binary().
+void prepare_program_for_binary_cache(GLuint program);
+
+} // namespace gl::internal
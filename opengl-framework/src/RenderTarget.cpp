@@ -22,11 +22,55 @@ static auto attachment_type(InternalFormat_DepthStencil format) -> GLenum
     }
 }
 
+static void check_framebuffer_status(GLenum status)
+{
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        const char* status_message = [&]() {
+            switch (status)
+            {
+            case GL_FRAMEBUFFER_UNDEFINED:
+                return "FRAMEBUFFER_UNDEFINED";
+            case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
+                return "FRAMEBUFFER_INCOMPLETE_ATTACHMENT";
+            case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
+                return "FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT";
+            case GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER:
+                return "FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER";
+            case GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER:
+                return "FRAMEBUFFER_INCOMPLETE_READ_BUFFER";
+            case GL_FRAMEBUFFER_UNSUPPORTED:
+                return "FRAMEBUFFER_UNSUPPORTED";
+            case GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE:
+                return "FRAMEBUFFER_INCOMPLETE_MULTISAMPLE";
+            case GL_FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS:
+                return "FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS";
+            default:
+                return "UNKNOWN_ERROR";
+            }
+        }();
+        handle_error(std::format("Invalid framebuffer: {}", status_message));
+    }
+}
+
+static auto has_stencil(InternalFormat_DepthStencil format) -> bool
+{
+    return attachment_type(format) != GL_DEPTH_ATTACHMENT;
+}
 
+static auto has_depth(InternalFormat_DepthStencil format) -> bool
+{
+    return attachment_type(format) != GL_STENCIL_ATTACHMENT;
+}
 
 void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
 {
     _color_textures.clear();
+    if (internal::supports_direct_state_access())
+    {
+        create_attachments_dsa(desc);
+        return;
+    }
     render([&]() { // HACK, we reuse render() as a way to have our framebuffer bound
         if (desc.color_textures.empty())
         { // We need to explicitly do this when have no color texture
@@ -58,39 +102,65 @@ void RenderTarget::create_attachments(RenderTarget_Descriptor const& desc)
             );
             glFramebufferTexture2D(GL_FRAMEBUFFER, attachment_type(desc.depth_stencil_texture->format), GL_TEXTURE_2D, _depth_stencil_texture->id(), 0);
         }
-        auto const status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-        if (status != GL_FRAMEBUFFER_COMPLETE)
-        {
-            const char* status_message = [&]() {
-                switch (status)
-                {
-                case GL_FRAMEBUFFER_UNDEFINED:
-                    return "FRAMEBUFFER_UNDEFINED";
-                case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
-                    return "FRAMEBUFFER_INCOMPLETE_ATTACHMENT";
-                case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
-                    return "FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT";
-                case GL_FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER:
-                    return "FRAMEBUFFER_INCOMPLETE_DRAW_BUFFER";
-                case GL_FRAMEBUFFER_INCOMPLETE_READ_BUFFER:
-                    return "FRAMEBUFFER_INCOMPLETE_READ_BUFFER";
-                case GL_FRAMEBUFFER_UNSUPPORTED:
-                    return "FRAMEBUFFER_UNSUPPORTED";
-                case GL_FRAMEBUFFER_INCOMPLETE_MULTISAMPLE:
-                    return "FRAMEBUFFER_INCOMPLETE_MULTISAMPLE";
-                case GL_FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS:
-                    return "FRAMEBUFFER_INCOMPLETE_LAYER_TARGETS";
-                default:
-                    return "UNKNOWN_ERROR";
-                }
-            }();
-            handle_error(std::format("Invalid framebuffer: {}", status_message));
-        }
+        check_framebuffer_status(glCheckFramebufferStatus(GL_FRAMEBUFFER));
         glClearColor(0.f, 0.f, 0.f, 0.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT); // Make sure to init the values in the framebuffer
     });
 }
 
+void RenderTarget::create_attachments_dsa(RenderTarget_Descriptor const& desc)
+{
+    auto const& ext = internal::gl_extensions();
+    if (desc.color_textures.empty())
+    { // We need to explicitly do this when have no color texture
+        ext.NamedFramebufferDrawBuffer(_id.id(), GL_NONE);
+        ext.NamedFramebufferReadBuffer(_id.id(), GL_NONE);
+    }
+    for (size_t i = 0; i < desc.color_textures.size(); ++i)
+    {
+        auto const& color_texture = desc.color_textures[i];
+        _color_textures.emplace_back(
+            TextureSource::EmptyImage{
+                .width          = desc.width,
+                .height         = desc.height,
+                .texture_format = static_cast<InternalFormatSized>(color_texture.format),
+            },
+            color_texture.options
+        );
+        ext.NamedFramebufferTexture(_id.id(), static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i), _color_textures.back().id(), 0);
+    }
+    if (desc.depth_stencil_texture.has_value())
+    {
+        _depth_stencil_texture.emplace(
+            TextureSource::EmptyImage{
+                .width          = desc.width,
+                .height         = desc.height,
+                .texture_format = static_cast<InternalFormatSized>(desc.depth_stencil_texture->format),
+            },
+            desc.depth_stencil_texture->options
+        );
+        ext.NamedFramebufferTexture(_id.id(), attachment_type(desc.depth_stencil_texture->format), _depth_stencil_texture->id(), 0);
+    }
+    check_framebuffer_status(ext.CheckNamedFramebufferStatus(_id.id(), GL_FRAMEBUFFER));
+
+    // Make sure to init the values in the framebuffer
+    auto const clear_color   = std::array{0.f, 0.f, 0.f, 0.f};
+    auto const clear_depth   = 1.f;
+    auto const clear_stencil = 0;
+    if (!desc.color_textures.empty())
+        ext.ClearNamedFramebufferfv(_id.id(), GL_COLOR, 0, clear_color.data());
+    if (desc.depth_stencil_texture.has_value())
+    {
+        auto const format = desc.depth_stencil_texture->format;
+        if (has_depth(format) && has_stencil(format))
+            ext.ClearNamedFramebufferfi(_id.id(), GL_DEPTH_STENCIL, 0, clear_depth, clear_stencil);
+        else if (has_depth(format))
+            ext.ClearNamedFramebufferfv(_id.id(), GL_DEPTH, 0, &clear_depth);
+        else
+            ext.ClearNamedFramebufferiv(_id.id(), GL_STENCIL, 0, &clear_stencil);
+    }
+}
+
 RenderTarget::RenderTarget(RenderTarget_Descriptor const& desc)
     : _desc{desc}
 {
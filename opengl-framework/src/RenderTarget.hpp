@@ -1,6 +1,7 @@
 #pragma once
 #include <functional>
 #include "Texture.hpp"
+#include "gl_extensions.hpp"
 #include "glad/gl.h"
 
 namespace gl {
@@ -10,7 +11,10 @@ class UniqueFramebuffer {
 public:
     UniqueFramebuffer() // NOLINT(*-member-init)
     {
-        glGenFramebuffers(1, &_id);
+        if (supports_direct_state_access())
+            gl_extensions().CreateFramebuffers(1, &_id);
+        else
+            glGenFramebuffers(1, &_id);
     }
     ~UniqueFramebuffer()
     {
@@ -74,6 +78,8 @@ public:
 
 private:
     void create_attachments(RenderTarget_Descriptor const& desc);
+    /// Same, with Direct State Access, which doesn't need to bind the framebuffer
+    void create_attachments_dsa(RenderTarget_Descriptor const& desc);
 
 private:
     internal::UniqueFramebuffer _id{};
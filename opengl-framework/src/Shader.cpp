@@ -1,50 +1,49 @@
 #include "Shader.hpp"
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <fstream>
+#include <memory>
+#include "ProgramBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
 #include "Texture.hpp"
+#include "TextureSampler.hpp"
+#include "UniformBuffer.hpp"
+#include "gl_extensions.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "handle_error.hpp"
-#include "make_absolute_path.hpp"
 
 namespace {
 
+/// Doesn't wait for the compilation to finish, call check_for_compilation_errors() for that.
 void compile_shader_module(GLuint id, std::string const& source_code)
 {
     char const* src = source_code.c_str();
     glShaderSource(id, 1, &src, nullptr);
     glCompileShader(id);
-
-    { // Check for errors
-        int result;
-        glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-        if (result)
-            return; // Compilation successful
-
-        GLsizei length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        std::vector<GLchar> error_message;
-        error_message.resize(static_cast<size_t>(length));
-        glGetShaderInfoLog(id, length, nullptr, error_message.data());
-        gl::handle_error(std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code));
-    }
 }
 
-auto get_source_code(gl::ShaderSource::Code const& source) -> std::string
-{
-    return source.code;
-}
-auto get_source_code(gl::ShaderSource::File const& source) -> std::string
+void check_for_compilation_errors(GLuint id, std::string const& source_code)
 {
-    auto ifs = std::ifstream{gl::make_absolute_path(source.path)};
-    return std::string{std::istreambuf_iterator<char>{ifs}, {}};
+    int result;
+    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+    if (result)
+        return; // Compilation successful
+
+    GLsizei length;
+    glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> error_message;
+    error_message.resize(static_cast<size_t>(length));
+    glGetShaderInfoLog(id, length, nullptr, error_message.data());
+    gl::handle_error(std::format("Shader Compilation failed:\n{}\n\nThe code we tried to compile was:\n{}", error_message.data(), source_code));
 }
 
+
 class UniqueShaderModule {
 public:
-    explicit UniqueShaderModule(GLenum shader_kind, gl::AnyShaderSource const& source)
-        : _id{glCreateShader(shader_kind)}
+    explicit UniqueShaderModule(gl::internal::ShaderStageSource const& source)
+        : _id{glCreateShader(source.stage)}
     {
-        compile_shader_module(_id, std::visit([](auto&& source) { return get_source_code(source); }, source));
+        compile_shader_module(_id, source.code);
     }
     ~UniqueShaderModule()
     {
@@ -89,20 +88,323 @@ void check_for_linking_errors(GLuint shader_id)
     }
 }
 
+auto is_sampler(GLenum uniform_type) -> bool
+{
+    switch (uniform_type)
+    {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_1D_SHADOW:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_1D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_1D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+    case GL_SAMPLER_BUFFER:
+    case GL_SAMPLER_2D_RECT:
+    case GL_SAMPLER_2D_RECT_SHADOW:
+    case GL_INT_SAMPLER_1D:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_3D:
+    case GL_INT_SAMPLER_CUBE:
+    case GL_INT_SAMPLER_1D_ARRAY:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_INT_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D_RECT:
+    case GL_UNSIGNED_INT_SAMPLER_1D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE:
+    case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+    case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+    case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+auto max_texture_units() -> GLint
+{
+    GLint res{};
+    glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &res);
+    return res;
+}
+
+template<typename T>
+auto as_bytes(T const& value) -> std::span<std::byte const>
+{
+    return std::as_bytes(std::span{&value, 1});
+}
+
+/// Connects the blocks that the shader declares to the buffers managed by the framework (see UniformBuffer.hpp).
+void connect_framework_uniform_block(GLuint shader_id, char const* block_name, GLuint binding, size_t block_size_on_cpu)
+{
+    auto const block_index = glGetUniformBlockIndex(shader_id, block_name);
+    if (block_index == GL_INVALID_INDEX) // The shader doesn't use this block
+        return;
+    GLint block_size_on_gpu{};
+    glGetActiveUniformBlockiv(shader_id, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block_size_on_gpu);
+    if (static_cast<size_t>(block_size_on_gpu) > block_size_on_cpu)
+        gl::handle_error(std::format("The {} block declared in your shader is {} bytes, but it should be at most {} bytes. Check that it matches the declaration in UniformBuffer.hpp, and that it uses layout(std140).", block_name, block_size_on_gpu, block_size_on_cpu));
+    glUniformBlockBinding(shader_id, block_index, binding);
+}
+
 } // namespace
 
 namespace gl {
 
+namespace internal {
+
+/// A program that has been submitted to the driver, but whose compilation and linking might not be done yet.
+class ShaderCompilation {
+public:
+    ShaderCompilation(std::vector<ShaderStageSource> stages, bool binary_cache)
+        : _stages{std::move(stages)}
+        , _binary_key{program_binary_key(_stages)}
+        , _binary_cache{binary_cache}
+    {
+        if (_binary_cache && load_program_binary(_program.id(), _binary_key))
+        {
+            _is_loaded_from_binary = true;
+            return;
+        }
+        // We don't check for errors here, because that would wait for the compilation to be done
+        for (auto const& stage : _stages)
+        {
+            auto const& module = _modules.emplace_back(stage);
+            glAttachShader(_program.id(), module.id());
+        }
+        if (_binary_cache)
+            prepare_program_for_binary_cache(_program.id());
+        glLinkProgram(_program.id());
+    }
+
+    /// Never blocks. Without KHR_parallel_shader_compile we can't know without waiting, so we consider that it is done.
+    auto is_done() const -> bool
+    {
+        if (_is_loaded_from_binary || !gl_extensions().parallel_shader_compile)
+            return true;
+        GLint is_done{};
+        glGetProgramiv(_program.id(), GL_COMPLETION_STATUS_KHR, &is_done);
+        return is_done == GL_TRUE;
+    }
+
+    /// Waits for the compilation if it is not done yet, and throws if it failed.
+    auto finish() && -> Shader
+    {
+        if (!_is_loaded_from_binary)
+        {
+            for (size_t i = 0; i < _modules.size(); ++i)
+                check_for_compilation_errors(_modules[i].id(), _stages[i].code);
+            check_for_linking_errors(_program.id());
+            for (auto const& module : _modules)
+                glDetachShader(_program.id(), module.id());
+            if (_binary_cache)
+                save_program_binary(_program.id(), _binary_key);
+        }
+        return Shader{std::move(_program)};
+    }
+
+private:
+    UniqueShader                    _program{};
+    std::vector<ShaderStageSource>  _stages;
+    std::vector<UniqueShaderModule> _modules{};
+    ProgramBinaryKey                _binary_key;
+    bool                            _binary_cache;
+    bool                            _is_loaded_from_binary{false};
+};
+
+} // namespace internal
+
+namespace {
+
+auto compilation_of(Shader_Descriptor const& desc) -> internal::ShaderCompilation
+{
+    return internal::ShaderCompilation{
+        {
+            internal::ShaderStageSource{.stage = GL_VERTEX_SHADER, .code = internal::inject_defines(internal::load_shader_source(desc.vertex), desc.defines)},
+            internal::ShaderStageSource{.stage = GL_FRAGMENT_SHADER, .code = internal::inject_defines(internal::load_shader_source(desc.fragment), desc.defines)},
+        },
+        desc.binary_cache,
+    };
+}
+
+struct PendingShaderCompilation {
+    internal::ShaderCompilation                      compilation;
+    std::weak_ptr<internal::AsyncAssetState<Shader>> state;
+};
+
+auto pending_shader_compilations() -> std::vector<PendingShaderCompilation>&
+{
+    static auto instance = std::vector<PendingShaderCompilation>{};
+    return instance;
+}
+
+void finish(PendingShaderCompilation& pending)
+{
+    auto const state = pending.state.lock();
+    if (!state) // Nobody is waiting for the shader anymore
+        return;
+    try
+    {
+        state->value.emplace(std::move(pending.compilation).finish());
+    }
+    catch (...)
+    {
+        state->error = std::current_exception();
+    }
+}
+
+} // namespace
+
+auto compile_shader_async(Shader_Descriptor const& desc) -> AsyncAsset<Shader>
+{
+    auto state = std::make_shared<internal::AsyncAssetState<Shader>>();
+    pending_shader_compilations().push_back({
+        .compilation = compilation_of(desc),
+        .state       = state,
+    });
+    return AsyncAsset<Shader>{std::move(state)};
+}
+
+void wait_for_shader_compilations()
+{
+    for (auto& pending : pending_shader_compilations())
+        finish(pending);
+    pending_shader_compilations().clear();
+}
+
+namespace internal {
+void process_pending_shader_compilations()
+{
+    std::erase_if(pending_shader_compilations(), [](PendingShaderCompilation& pending) {
+        if (!pending.compilation.is_done())
+            return false;
+        finish(pending);
+        return true;
+    });
+}
+} // namespace internal
+
 Shader::Shader(Shader_Descriptor const& desc)
+    : Shader{compilation_of(desc).finish()}
+{}
+
+namespace internal {
+auto compile_program(std::vector<ShaderStageSource> stages, bool binary_cache) -> Shader
+{
+    return ShaderCompilation{std::move(stages), binary_cache}.finish();
+}
+} // namespace internal
+
+Shader::Shader(internal::UniqueShader program)
+    : _id{std::move(program)}
+{
+    query_uniform_locations();
+    connect_framework_uniform_block(id(), "FrameUniforms", UniformBinding::Frame, sizeof(FrameUniforms));
+    connect_framework_uniform_block(id(), "ObjectUniforms", UniformBinding::Object, sizeof(ObjectUniforms));
+}
+
+void Shader::query_uniform_locations()
+{
+    GLint uniforms_count{};
+    GLint max_name_length{};
+    glGetProgramiv(id(), GL_ACTIVE_UNIFORMS, &uniforms_count);
+    glGetProgramiv(id(), GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    auto name_buffer       = std::vector<GLchar>(static_cast<size_t>(max_name_length));
+    auto sampler_locations = std::vector<GLint>{};
+    for (GLuint i = 0; i < static_cast<GLuint>(uniforms_count); ++i)
+    {
+        GLsizei name_length{};
+        GLint   array_size{};
+        GLenum  type{};
+        glGetActiveUniform(id(), i, max_name_length, &name_length, &array_size, &type, name_buffer.data());
+        auto const name     = std::string{name_buffer.data(), static_cast<size_t>(name_length)};
+        auto const location = glGetUniformLocation(id(), name.c_str());
+        if (location == -1) // Uniforms that live in a uniform block don't have a location
+            continue;
+        _uniform_locations[name] = location;
+        if (is_sampler(type))
+            sampler_locations.push_back(location);
+
+        // Arrays are reported as "name[0]", but we also want to find them as "name", and find each element as "name[i]"
+        if (!name.ends_with("[0]"))
+            continue;
+        auto const array_name          = name.substr(0, name.size() - 3);
+        _uniform_locations[array_name] = location;
+        for (GLint element = 1; element < array_size; ++element)
+        {
+            auto const element_name            = std::format("{}[{}]", array_name, element);
+            _uniform_locations[element_name] = glGetUniformLocation(id(), element_name.c_str());
+            if (is_sampler(type))
+                sampler_locations.push_back(_uniform_locations[element_name]);
+        }
+    }
+
+    auto max_location = GLint{-1};
+    for (auto const& [_, location] : _uniform_locations)
+        max_location = std::max(max_location, location);
+    _uniform_values.resize(static_cast<size_t>(max_location + 1));
+    assign_texture_units(sampler_locations);
+}
+
+void Shader::assign_texture_units(std::span<GLint const> sampler_locations)
+{
+    _texture_units.assign(_uniform_values.size(), -1);
+    // Without Direct State Access, textures are bound to unit 0 while we edit them (see bind_texture_for_editing()), so we don't render with it
+    auto const first_unit = internal::supports_direct_state_access() ? 0 : 1;
+    auto const max_units  = max_texture_units();
+    if (first_unit + static_cast<GLint>(sampler_locations.size()) > max_units)
+        handle_error(std::format("Your shader uses {} textures, but your GPU only has {} texture units.", sampler_locations.size(), max_units));
+
+    auto unit = first_unit;
+    for (GLint const location : sampler_locations)
+    {
+        glProgramUniform1i(id(), location, unit);
+        _texture_units[static_cast<size_t>(location)] = unit;
+        unit++;
+    }
+}
+
+auto Shader::uniform_value_has_changed(GLint location, std::span<std::byte const> value) const -> bool
 {
-    auto vertex_shader   = UniqueShaderModule{GL_VERTEX_SHADER, desc.vertex};
-    auto fragment_shader = UniqueShaderModule{GL_FRAGMENT_SHADER, desc.fragment};
-    glAttachShader(id(), vertex_shader.id());
-    glAttachShader(id(), fragment_shader.id());
-    glLinkProgram(id());
-    glDetachShader(id(), fragment_shader.id());
-    glDetachShader(id(), vertex_shader.id());
-    check_for_linking_errors(id());
+    if (location == -1) // glUniform*() would ignore it anyway
+    {
+        internal::state_cache_record_call(true);
+        return false;
+    }
+    if (_uniform_values_generation != internal::state_cache_generation())
+    {
+        _uniform_values_generation = internal::state_cache_generation();
+        std::fill(_uniform_values.begin(), _uniform_values.end(), CachedUniformValue{});
+    }
+
+    assert(static_cast<size_t>(location) < _uniform_values.size());
+    assert(value.size() <= sizeof(CachedUniformValue::bytes));
+    auto&      cached_value = _uniform_values[static_cast<size_t>(location)];
+    auto const changed      = cached_value.size != value.size() || !std::equal(value.begin(), value.end(), cached_value.bytes.begin());
+    internal::state_cache_record_call(!changed);
+    if (changed)
+    {
+        std::copy(value.begin(), value.end(), cached_value.bytes.begin());
+        cached_value.size = value.size();
+    }
+    return changed;
 }
 
 static void assert_shader_is_bound(GLuint id)
@@ -118,124 +420,136 @@ static void assert_shader_is_bound(GLuint id)
 
 void Shader::bind() const
 {
-    glUseProgram(id());
+    StateCache::use_program(id());
 }
 
 auto Shader::uniform_location(std::string_view uniform_name) const -> GLint
 {
-    auto const name = std::string{uniform_name};
-    auto const it   = _uniform_locations.find(name);
-    if (it != _uniform_locations.end())
-    {
-        return it->second;
-    }
-    else
-    {
-        GLint const location     = glGetUniformLocation(id(), name.c_str());
-        _uniform_locations[name] = location;
-        return location;
-    }
+    auto const it = _uniform_locations.find(uniform_name);
+    return it != _uniform_locations.end() ? it->second : -1; // -1 is silently ignored by glUniform*(), just like when glGetUniformLocation() doesn't find a uniform
 }
 
-void Shader::set_uniform(std::string_view uniform_name, int v) const
+auto Shader::uniform_handle(std::string_view uniform_name) const -> UniformHandle
 {
-    assert_shader_is_bound(id());
-    glUniform1i(uniform_location(uniform_name), v);
+    return UniformHandle{uniform_location(uniform_name), id()};
 }
-void Shader::set_uniform(std::string_view uniform_name, unsigned int v) const
+
+void Shader::assert_handle_belongs_to_this_shader([[maybe_unused]] UniformHandle handle) const
 {
-    set_uniform(uniform_name, static_cast<int>(v));
+    assert(handle._shader_id == id() && "This UniformHandle has been created by another shader.");
 }
-void Shader::set_uniform(std::string_view uniform_name, bool v) const
+
+void Shader::set_uniform(std::string_view uniform_name, int v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, unsigned int v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, bool v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, float v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::vec2 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::vec3 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::vec4 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::uvec2 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::uvec3 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::uvec4 const& v) const { set_uniform(uniform_handle(uniform_name), v); }
+void Shader::set_uniform(std::string_view uniform_name, glm::mat2 const& mat) const { set_uniform(uniform_handle(uniform_name), mat); }
+void Shader::set_uniform(std::string_view uniform_name, glm::mat3 const& mat) const { set_uniform(uniform_handle(uniform_name), mat); }
+void Shader::set_uniform(std::string_view uniform_name, glm::mat4 const& mat) const { set_uniform(uniform_handle(uniform_name), mat); }
+void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const { set_uniform(uniform_handle(uniform_name), texture); }
+
+void Shader::set_uniform(UniformHandle handle, int v) const
 {
-    set_uniform(uniform_name, v ? 1 : 0);
+    assert_shader_is_bound(id());
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform1i(handle.location(), v);
 }
-void Shader::set_uniform(std::string_view uniform_name, float v) const
+void Shader::set_uniform(UniformHandle handle, unsigned int v) const
 {
-    assert_shader_is_bound(id());
-    glUniform1f(uniform_location(uniform_name), v);
+    set_uniform(handle, static_cast<int>(v));
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::vec2& v) const
+void Shader::set_uniform(UniformHandle handle, bool v) const
 {
-    assert_shader_is_bound(id());
-    glUniform2f(uniform_location(uniform_name), v.x, v.y);
+    set_uniform(handle, v ? 1 : 0);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::vec3& v) const
+void Shader::set_uniform(UniformHandle handle, float v) const
 {
     assert_shader_is_bound(id());
-    glUniform3f(uniform_location(uniform_name), v.x, v.y, v.z);
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform1f(handle.location(), v);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::vec4& v) const
+void Shader::set_uniform(UniformHandle handle, const glm::vec2& v) const
 {
     assert_shader_is_bound(id());
-    glUniform4f(uniform_location(uniform_name), v.x, v.y, v.z, v.w);
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform2f(handle.location(), v.x, v.y);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::uvec2& v) const
+void Shader::set_uniform(UniformHandle handle, const glm::vec3& v) const
 {
     assert_shader_is_bound(id());
-    glUniform2ui(uniform_location(uniform_name), v.x, v.y);
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform3f(handle.location(), v.x, v.y, v.z);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::uvec3& v) const
+void Shader::set_uniform(UniformHandle handle, const glm::vec4& v) const
 {
     assert_shader_is_bound(id());
-    glUniform3ui(uniform_location(uniform_name), v.x, v.y, v.z);
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform4f(handle.location(), v.x, v.y, v.z, v.w);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::uvec4& v) const
+void Shader::set_uniform(UniformHandle handle, const glm::uvec2& v) const
 {
     assert_shader_is_bound(id());
-    glUniform4ui(uniform_location(uniform_name), v.x, v.y, v.z, v.w);
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform2ui(handle.location(), v.x, v.y);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::mat2& mat) const
+void Shader::set_uniform(UniformHandle handle, const glm::uvec3& v) const
 {
     assert_shader_is_bound(id());
-    glUniformMatrix2fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform3ui(handle.location(), v.x, v.y, v.z);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::mat3& mat) const
+void Shader::set_uniform(UniformHandle handle, const glm::uvec4& v) const
 {
     assert_shader_is_bound(id());
-    glUniformMatrix3fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(v)))
+        glUniform4ui(handle.location(), v.x, v.y, v.z, v.w);
 }
-void Shader::set_uniform(std::string_view uniform_name, const glm::mat4& mat) const
+void Shader::set_uniform(UniformHandle handle, const glm::mat2& mat) const
 {
     assert_shader_is_bound(id());
-    glUniformMatrix4fv(uniform_location(uniform_name), 1, GL_FALSE, glm::value_ptr(mat));
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(mat)))
+        glUniformMatrix2fv(handle.location(), 1, GL_FALSE, glm::value_ptr(mat));
 }
-
-static auto max_number_of_texture_slots() -> GLuint
+void Shader::set_uniform(UniformHandle handle, const glm::mat3& mat) const
 {
-    GLint res{};
-    glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &res);
-    return static_cast<GLuint>(res);
+    assert_shader_is_bound(id());
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(mat)))
+        glUniformMatrix3fv(handle.location(), 1, GL_FALSE, glm::value_ptr(mat));
 }
-
-static auto get_next_texture_slot() -> GLuint
+void Shader::set_uniform(UniformHandle handle, const glm::mat4& mat) const
 {
-    static GLuint       current_slot = 0;
-    static GLuint const max_slots    = max_number_of_texture_slots();
-
-    current_slot = (current_slot + 1) % max_slots;
-    if (current_slot == 0) // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
-        current_slot = 1;
-    return current_slot;
+    assert_shader_is_bound(id());
+    assert_handle_belongs_to_this_shader(handle);
+    if (uniform_value_has_changed(handle.location(), as_bytes(mat)))
+        glUniformMatrix4fv(handle.location(), 1, GL_FALSE, glm::value_ptr(mat));
 }
 
-void Shader::set_uniform(std::string_view uniform_name, Texture const& texture) const
+void Shader::set_uniform(UniformHandle handle, Texture const& texture) const
 {
-    auto const slot = get_next_texture_slot();
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, texture.id());
-    set_uniform(uniform_name, slot);
-    glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
+    assert_handle_belongs_to_this_shader(handle);
+    if (!handle.exists())
+        return;
+    auto const unit = _texture_units[static_cast<size_t>(handle.location())];
+    assert(unit != -1 && "This uniform is not a sampler.");
+    // The uniform already points to this unit since the shader was linked, so we only need to bind the texture (and nothing happens if it is already bound)
+    StateCache::bind_texture(static_cast<GLuint>(unit), texture.id());
+    StateCache::bind_sampler(static_cast<GLuint>(unit), TextureSamplerLibrary::instance().get(texture.options()).id());
 }
 
-// void Shader::set_uniform_texture(std::string_view uniform_name, GLuint texture_id, TextureSamplerDescriptor const& sampler) const
-// {
-//     auto const slot = get_next_texture_slot();
-//     glActiveTexture(GL_TEXTURE0 + slot);
-//     glBindTexture(GL_TEXTURE_2D, texture_id);
-//     glBindSampler(slot, TextureSamplerLibrary::instance().get(sampler).id()));
-//     set_uniform(uniform_name, static_cast<int>(slot));
-//     glActiveTexture(GL_TEXTURE0); // HACK Slot 0 is used for texture operations like resizing and setting the image, anyone might override the texture set here at any time. So we use all slots but the 0th one for rendering.
-// }
-
 } // namespace gl
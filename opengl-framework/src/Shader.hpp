@@ -1,12 +1,20 @@
 #pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <span>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <variant>
+#include <vector>
+#include "AsyncAsset.hpp"
+#include "StateCache.hpp"
 #include "Texture.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
+#include "hash.hpp"
 
 namespace gl {
 
@@ -18,6 +26,7 @@ public:
     {}
     ~UniqueShader()
     {
+        state_cache_forget_program(_id);
         glDeleteProgram(_id);
     }
     UniqueShader(UniqueShader const&)                    = delete; // You cannot copy
@@ -31,6 +40,7 @@ public:
     {
         if (&o != this)
         {
+            state_cache_forget_program(_id);
             glDeleteProgram(_id);
             _id   = o._id;
             o._id = 0;
@@ -45,6 +55,7 @@ private:
 };
 } // namespace internal
 
+/// Both can use `#include "path/to/file.glsl"` (see load_shader_source()).
 namespace ShaderSource {
 struct File {
     std::filesystem::path path;
@@ -58,18 +69,63 @@ using AnyShaderSource = std::variant<
     ShaderSource::File,
     ShaderSource::Code>;
 
+/// The location of a uniform, resolved once with Shader::uniform_handle(), so that setting it doesn't involve any lookup by name.
+/// It is only valid for the shader that created it.
+class UniformHandle {
+public:
+    UniformHandle() = default;
+
+    auto location() const -> GLint { return _location; }
+    /// False when the shader doesn't have this uniform (or when the compiler removed it because it is not used). Setting it is then a no-op.
+    auto exists() const -> bool { return _location != -1; }
+
+private:
+    friend class Shader;
+    UniformHandle(GLint location, [[maybe_unused]] GLuint shader_id)
+        : _location{location}
+#ifndef NDEBUG
+        , _shader_id{shader_id}
+#endif
+    {}
+
+private:
+    GLint _location{-1};
+#ifndef NDEBUG
+    GLuint _shader_id{};
+#endif
+};
+
 struct Shader_Descriptor {
     AnyShaderSource vertex{};
     AnyShaderSource fragment{};
+    /// Added to the code of all the stages, e.g. {"USE_SHADOWS", "LIGHTS_COUNT 4"}. To compile several variants of the same shader, use ShaderVariants instead.
+    std::vector<std::string> defines{};
+    /// The first time a shader is compiled, the driver's binary is saved in the cache folder (see set_shader_binary_cache_folder()), and the next launches load it instead of compiling again.
+    /// It is automatically recompiled when the code or the driver changes.
+    bool binary_cache{true};
 };
 
+/// Where the compiled shaders are stored. Defaults to a "shader_cache" folder next to the executable. Pass an empty path to disable the cache for all the shaders.
+void set_shader_binary_cache_folder(std::filesystem::path);
+
+namespace internal {
+class ShaderCompilation;
+struct ShaderStageSource;
+} // namespace internal
+
 class Shader {
 public:
+    /// Compiles the shader and waits until it is done. To compile many shaders at once, use compile_shader_async() instead.
     explicit Shader(Shader_Descriptor const&);
 
     auto id() const -> GLuint { return _id.id(); }
 
     void bind() const;
+
+    /// Looks up the uniform once, so that you can then set it without any cost other than the OpenGL call.
+    /// e.g. store `auto const transform = shader.uniform_handle("_transform");` next to your shader, and call `shader.set_uniform(transform, matrix);` each frame.
+    auto uniform_handle(std::string_view uniform_name) const -> UniformHandle;
+
     void set_uniform(std::string_view uniform_name, int) const;
     void set_uniform(std::string_view uniform_name, unsigned int) const;
     void set_uniform(std::string_view uniform_name, bool) const;
@@ -85,12 +141,60 @@ public:
     void set_uniform(std::string_view uniform_name, glm::mat4 const&) const;
     void set_uniform(std::string_view uniform_name, Texture const&) const;
 
+    void set_uniform(UniformHandle, int) const;
+    void set_uniform(UniformHandle, unsigned int) const;
+    void set_uniform(UniformHandle, bool) const;
+    void set_uniform(UniformHandle, float) const;
+    void set_uniform(UniformHandle, glm::vec2 const&) const;
+    void set_uniform(UniformHandle, glm::vec3 const&) const;
+    void set_uniform(UniformHandle, glm::vec4 const&) const;
+    void set_uniform(UniformHandle, glm::uvec2 const&) const;
+    void set_uniform(UniformHandle, glm::uvec3 const&) const;
+    void set_uniform(UniformHandle, glm::uvec4 const&) const;
+    void set_uniform(UniformHandle, glm::mat2 const&) const;
+    void set_uniform(UniformHandle, glm::mat3 const&) const;
+    void set_uniform(UniformHandle, glm::mat4 const&) const;
+    void set_uniform(UniformHandle, Texture const&) const;
+
 private:
+    friend class internal::ShaderCompilation;
+    /// The program must have been successfully linked.
+    explicit Shader(internal::UniqueShader program);
+
+    /// Fills _uniform_locations with all the uniforms of the program, once it has been linked.
+    void query_uniform_locations();
+    /// Gives each sampler its own texture unit, once and for all, so that setting a texture only has to bind it.
+    void assign_texture_units(std::span<GLint const> sampler_locations);
     auto uniform_location(std::string_view uniform_name) const -> GLint;
+    void assert_handle_belongs_to_this_shader(UniformHandle) const;
+    /// Returns false if the uniform already has this value, in which case there is no need to send it to the driver again.
+    auto uniform_value_has_changed(GLint location, std::span<std::byte const> value) const -> bool;
 
 private:
-    internal::UniqueShader                         _id{};
-    mutable std::unordered_map<std::string, GLint> _uniform_locations{};
+    internal::UniqueShader                                                        _id{};
+    std::unordered_map<std::string, GLint, internal::StringHash, std::equal_to<>> _uniform_locations{}; // Transparent, so that we can search it with a std::string_view without allocating a std::string
+
+    struct CachedUniformValue {
+        std::array<std::byte, sizeof(glm::mat4)> bytes{}; // Big enough for the biggest type we support
+        size_t                                   size{0}; // 0 means that we don't know the value
+    };
+    mutable std::vector<CachedUniformValue> _uniform_values{}; // Indexed by location
+    mutable uint64_t                        _uniform_values_generation{};
+    std::vector<GLint>                      _texture_units{}; // Indexed by location, -1 for the uniforms that are not samplers
 };
 
+/// Submits the shader to the driver, and returns immediately. The shader becomes ready during a call to gl::window_is_open(), once the driver is done compiling it.
+/// Submit all your shaders before waiting for any of them: when the driver supports KHR_parallel_shader_compile they are all compiled at the same time, on several threads.
+/// Otherwise they are compiled one after the other, but still without blocking until you need them.
+auto compile_shader_async(Shader_Descriptor const&) -> AsyncAsset<Shader>;
+/// Blocks until all the shaders submitted with compile_shader_async() are ready. e.g. at the end of your loading screen.
+void wait_for_shader_compilations();
+
+namespace internal {
+/// Called once per frame by window_is_open().
+void process_pending_shader_compilations();
+/// Compiles and links any combination of stages, e.g. a single GL_COMPUTE_SHADER, and waits until it is done.
+auto compile_program(std::vector<ShaderStageSource> stages, bool binary_cache) -> Shader;
+} // namespace internal
+
 } // namespace gl
\ No newline at end of file
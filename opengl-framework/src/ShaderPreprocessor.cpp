@@ -0,0 +1,193 @@
+#include "ShaderPreprocessor.hpp"
+#include <cctype>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "exe_path/exe_path.h"
+#include "handle_error.hpp"
+#include "make_absolute_path.hpp"
+
+namespace gl::internal {
+
+namespace {
+
+struct IncludeContext {
+    /// Indexed by source string number. The first one is the file we start from (or empty for a ShaderSource::Code).
+    std::vector<std::filesystem::path> files{};
+};
+
+auto read_file(std::filesystem::path const& path) -> std::string
+{
+    auto ifs = std::ifstream{path};
+    if (!ifs)
+        handle_error(std::format("Failed to open shader file \"{}\".", path.string()));
+    return std::string{std::istreambuf_iterator<char>{ifs}, {}};
+}
+
+auto trim_start(std::string_view str) -> std::string_view
+{
+    auto const begin = str.find_first_not_of(" \t");
+    return begin == std::string_view::npos ? std::string_view{} : str.substr(begin);
+}
+
+/// Returns the path inside the quotes if the line is an #include directive.
+auto included_path(std::string_view line) -> std::optional<std::string_view>
+{
+    line = trim_start(line);
+    if (!line.starts_with('#'))
+        return std::nullopt;
+    line = trim_start(line.substr(1)); // There can be spaces between the # and the directive
+    if (!line.starts_with("include"))
+        return std::nullopt;
+    line = trim_start(line.substr(std::string_view{"include"}.size()));
+
+    auto const end = line.find('"', 1);
+    if (!line.starts_with('"') || end == std::string_view::npos)
+        handle_error(std::format("Invalid directive: `{}`. It should look like `#include \"path/to/file.glsl\"`.", line));
+    return line.substr(1, end - 1);
+}
+
+/// Updates `is_in_block_comment` with the `/*` and `*/` of the line. Ignores everything after a `//`.
+void update_block_comment_state(std::string_view line, bool& is_in_block_comment)
+{
+    for (size_t i = 0; i + 1 < line.size(); ++i)
+    {
+        auto const two_chars = line.substr(i, 2);
+        if (is_in_block_comment)
+        {
+            if (two_chars == "*/")
+            {
+                is_in_block_comment = false;
+                ++i;
+            }
+        }
+        else if (two_chars == "//")
+        {
+            return;
+        }
+        else if (two_chars == "/*")
+        {
+            is_in_block_comment = true;
+            ++i;
+        }
+    }
+}
+
+void expand_includes(std::string_view code, std::filesystem::path const& folder, size_t source_string, IncludeContext& context, std::string& result)
+{
+    size_t line_number         = 1;
+    bool   is_in_block_comment = false;
+    for (size_t line_start = 0; line_start < code.size(); ++line_number)
+    {
+        auto const line_end = std::min(code.find('\n', line_start), code.size());
+        auto const line     = code.substr(line_start, line_end - line_start);
+        line_start          = line_end + 1;
+
+        auto const starts_in_block_comment = is_in_block_comment;
+        update_block_comment_state(line, is_in_block_comment);
+        auto const include = starts_in_block_comment ? std::nullopt : included_path(line); // e.g. a commented-out include of a file that doesn't exist anymore
+        if (!include)
+        {
+            result += line;
+            result += '\n';
+            continue;
+        }
+
+        auto const path = folder / *include;
+        if (!std::filesystem::exists(path))
+            handle_error(std::format("Can't #include \"{}\": \"{}\" does not exist. The path must be relative to the file that includes it.", *include, path.string()));
+        auto const canonical_path = std::filesystem::weakly_canonical(path);
+        if (std::find(context.files.begin(), context.files.end(), canonical_path) != context.files.end())
+        {
+            result += '\n'; // Already included, we keep the line so that the line numbers don't change
+            continue;
+        }
+        auto const included_source_string = context.files.size();
+        context.files.push_back(canonical_path);
+
+        // The #line directives make the compiler report the errors with the line numbers of the original files
+        result += std::format("// Source string {} is \"{}\"\n#line 1 {}\n", included_source_string, canonical_path.string(), included_source_string);
+        expand_includes(read_file(canonical_path), canonical_path.parent_path(), included_source_string, context, result);
+        result += std::format("#line {} {}\n", line_number + 1, source_string);
+    }
+}
+
+} // namespace
+
+auto load_shader_source(AnyShaderSource const& source) -> std::string
+{
+    auto context = IncludeContext{};
+    auto result  = std::string{};
+    std::visit(
+        [&](auto&& source) {
+            using T = std::decay_t<decltype(source)>;
+            if constexpr (std::is_same_v<T, ShaderSource::File>)
+            {
+                auto const path = std::filesystem::weakly_canonical(make_absolute_path(source.path));
+                context.files.push_back(path);
+                expand_includes(read_file(path), path.parent_path(), 0, context, result);
+            }
+            else
+            {
+                context.files.emplace_back();
+                expand_includes(source.code, exe_path::dir(), 0, context, result);
+            }
+        },
+        source
+    );
+    return result;
+}
+
+auto inject_defines(std::string const& code, std::span<std::string const> defines) -> std::string
+{
+    if (defines.empty())
+        return code;
+
+    // The #version directive must come first, so we insert the defines right after it
+    size_t insertion_position = 0; // If there is no #version, at the very beginning
+    size_t next_line_number   = 1;
+    size_t line_number        = 1;
+    for (size_t line_start = 0; line_start < code.size(); ++line_number)
+    {
+        auto const line_end = std::min(code.find('\n', line_start), code.size());
+        if (trim_start(std::string_view{code}.substr(line_start, line_end - line_start)).starts_with("#version"))
+        {
+            insertion_position = std::min(line_end + 1, code.size());
+            next_line_number   = line_number + 1;
+            break;
+        }
+        line_start = line_end + 1;
+    }
+
+    auto directives = std::string{};
+    if (insertion_position == code.size() && !code.ends_with('\n'))
+        directives += '\n';
+    for (auto const& define : defines)
+        directives += std::format("#define {}\n", define);
+    directives += std::format("#line {} 0\n", next_line_number);
+
+    auto result = code;
+    result.insert(insertion_position, directives);
+    return result;
+}
+
+auto uses_identifier(std::string_view code, std::string_view name) -> bool
+{
+    auto const is_identifier_char = [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    };
+    for (auto position = code.find(name); position != std::string_view::npos; position = code.find(name, position + 1))
+    {
+        auto const end = position + name.size();
+        if ((position == 0 || !is_identifier_char(code[position - 1]))
+            && (end == code.size() || !is_identifier_char(code[end])))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace gl::internal
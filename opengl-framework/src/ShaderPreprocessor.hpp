@@ -0,0 +1,22 @@
+#pragma once
+#include <span>
+#include <string>
+#include <string_view>
+#include "Shader.hpp"
+
+namespace gl::internal {
+
+/// Reads the code, and replaces each `#include "path/to/file.glsl"` with the content of that file.
+/// The paths are relative to the folder of the file that includes them (or to the folder of the executable for a ShaderSource::Code).
+/// Each file is only included once, like with `#pragma once`, so that they can include each other freely.
+/// The includes are unconditional: an `#include` inside an `#if` / `#ifdef` block is expanded even if the block is compiled out. Only the ones inside comments are ignored.
+/// The compiler's error messages refer to the included files by number: the code of each file is preceded by a comment that gives its number.
+auto load_shader_source(AnyShaderSource const&) -> std::string;
+
+/// Adds a `#define` for each of the defines right after the `#version` directive, e.g. "USE_SHADOWS" or "LIGHTS_COUNT 4".
+auto inject_defines(std::string const& code, std::span<std::string const> defines) -> std::string;
+
+/// Returns true iff the name appears in the code as a whole word, e.g. when the code uses `#ifdef name`.
+auto uses_identifier(std::string_view code, std::string_view name) -> bool;
+
+} // namespace gl::internal
@@ -0,0 +1,98 @@
+#include "ShaderVariants.hpp"
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <unordered_set>
+#include "ProgramBinaryCache.hpp"
+#include "ShaderPreprocessor.hpp"
+#include "handle_error.hpp"
+
+namespace gl {
+
+namespace {
+
+/// Shared by all the ShaderVariants, so that two of them that produce the same code (e.g. because they include the same files) also share the program.
+/// Only holds weak references: a program is deleted as soon as no ShaderVariants uses it anymore.
+auto programs_cache() -> std::unordered_map<internal::ProgramBinaryKey, std::weak_ptr<Shader const>, internal::ProgramBinaryKeyHash>&
+{
+    static auto instance = std::unordered_map<internal::ProgramBinaryKey, std::weak_ptr<Shader const>, internal::ProgramBinaryKeyHash>{};
+    return instance;
+}
+
+auto get_or_create_program(Shader_Descriptor const& desc, std::array<internal::ShaderStageSource, 2> const& stages) -> std::shared_ptr<Shader const>
+{
+    auto const key     = internal::program_binary_key(stages);
+    auto&      program = programs_cache()[key];
+    if (auto shared_program = program.lock())
+        return shared_program;
+
+    auto shared_program = std::make_shared<Shader const>(desc);
+    program             = shared_program;
+    return shared_program;
+}
+
+} // namespace
+
+ShaderVariants::ShaderVariants(ShaderVariants_Descriptor const& desc)
+    : _code{internal::load_shader_source(desc.vertex), internal::load_shader_source(desc.fragment)}
+    , _features{desc.features}
+    , _defines{desc.defines}
+    , _binary_cache{desc.binary_cache}
+{
+    if (_features.size() > 64)
+        handle_error(std::format("[ShaderVariants] You have {} features, but ShaderFeatures can only hold 64 of them.", _features.size()));
+    for (size_t i = 0; i < std::min(_features.size(), size_t{64}); ++i)
+    {
+        if (std::any_of(_code.begin(), _code.end(), [&](std::string const& code) { return internal::uses_identifier(code, _features[i]); }))
+            _used_features |= ShaderFeatures{1} << i;
+    }
+}
+
+auto ShaderVariants::get(ShaderFeatures features) -> Shader const&
+{
+    features &= _used_features;
+    auto& variant = _variants[features];
+    if (variant)
+        return *variant;
+
+    auto defines = _defines;
+    for (size_t i = 0; i < _features.size(); ++i)
+    {
+        if (features & (ShaderFeatures{1} << i))
+            defines.push_back(_features[i]);
+    }
+    auto const vertex   = internal::inject_defines(_code[0], defines);
+    auto const fragment = internal::inject_defines(_code[1], defines);
+    variant             = get_or_create_program(
+        {
+            .vertex       = ShaderSource::Code{vertex}, // The #includes have already been resolved, and the defines injected
+            .fragment     = ShaderSource::Code{fragment},
+            .binary_cache = _binary_cache,
+        },
+        {
+            internal::ShaderStageSource{.stage = GL_VERTEX_SHADER, .code = vertex},
+            internal::ShaderStageSource{.stage = GL_FRAGMENT_SHADER, .code = fragment},
+        }
+    );
+    return *variant;
+}
+
+auto ShaderVariants::feature(std::string_view name) const -> ShaderFeatures
+{
+    auto const it = std::find(_features.begin(), _features.end(), name);
+    assert(it != _features.end() && "This feature doesn't exist. Check that it is listed in ShaderVariants_Descriptor::features.");
+    return ShaderFeatures{1} << static_cast<size_t>(it - _features.begin());
+}
+
+auto ShaderVariants::compiled_variants_count() const -> size_t
+{
+    auto programs = std::unordered_set<Shader const*>{};
+    for (auto const& [_, variant] : _variants)
+    {
+        if (variant) // Null if its compilation failed
+            programs.insert(variant.get());
+    }
+    return programs.size();
+}
+
+} // namespace gl
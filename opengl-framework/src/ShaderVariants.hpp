@@ -0,0 +1,54 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Shader.hpp"
+
+namespace gl {
+
+/// A set of features, one bit per feature: bit i is the i-th feature of ShaderVariants_Descriptor::features.
+using ShaderFeatures = uint64_t;
+
+struct ShaderVariants_Descriptor {
+    AnyShaderSource vertex{};
+    AnyShaderSource fragment{};
+    /// e.g. {"USE_NORMAL_MAP", "USE_SHADOWS"}. Each variant #defines the features that it enables, so that the code can use `#ifdef USE_SHADOWS`, and the branches of the disabled features are not even compiled. At most 64 features.
+    std::vector<std::string> features{};
+    /// Defined in all the variants.
+    std::vector<std::string> defines{};
+    /// See Shader_Descriptor::binary_cache.
+    bool binary_cache{true};
+};
+
+/// All the variants (a.k.a. permutations) of a shader, that you get by enabling or disabling some of its features.
+/// Each variant is only compiled the first time you use it, and variants that end up with the same code (e.g. because they only differ by features that the code doesn't use) share the same program.
+class ShaderVariants {
+public:
+    /// Reads the files right away, but doesn't compile anything.
+    explicit ShaderVariants(ShaderVariants_Descriptor const&);
+
+    /// e.g. `shaders.get(shaders.feature("USE_SHADOWS") | shaders.feature("USE_NORMAL_MAP"))`.
+    /// Compiles the variant the first time it is requested, and is then just a lookup in a hash map. Store the result rather than calling it for each draw.
+    auto get(ShaderFeatures) -> Shader const&;
+
+    /// The bit of the given feature. Look it up once and store it.
+    auto feature(std::string_view name) const -> ShaderFeatures;
+
+    /// The number of different programs that have been compiled so far.
+    auto compiled_variants_count() const -> size_t;
+
+private:
+    std::array<std::string, 2>                                        _code{}; // Vertex and fragment, with all their #includes resolved
+    std::vector<std::string>                                          _features{};
+    std::vector<std::string>                                          _defines{};
+    ShaderFeatures                                                    _used_features{}; // The features that the code doesn't use are ignored, so that they don't create more variants
+    bool                                                              _binary_cache{};
+    std::unordered_map<ShaderFeatures, std::shared_ptr<Shader const>> _variants{};
+};
+
+} // namespace gl
@@ -0,0 +1,200 @@
+#include "StateCache.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "gl_extensions.hpp"
+
+namespace gl {
+
+namespace {
+
+/// No object can have this name, so it never matches the value that we want to set, and the next call always goes through.
+constexpr GLuint unknown = std::numeric_limits<GLuint>::max();
+
+struct State {
+    GLuint                             program{unknown};
+    GLuint                             vertex_array{unknown};
+    GLuint                             active_texture_unit{unknown};
+    std::vector<GLuint>                textures{};     // Indexed by texture unit, grows on demand
+    std::vector<GLuint>                samplers{};     // Indexed by texture unit, grows on demand
+    std::unordered_map<GLenum, GLuint> capabilities{}; // The booleans are stored as GLuint, so that they can be unknown
+    std::array<GLenum, 4>              blend_function{unknown, unknown, unknown, unknown};
+    GLenum                             depth_function{unknown};
+    GLuint                             depth_mask{unknown};
+
+    uint64_t           generation{0};
+    StateCacheCounters current_frame{};
+    StateCacheCounters previous_frame{};
+};
+
+auto state() -> State&
+{
+    static auto instance = State{};
+    return instance;
+}
+
+/// Returns true iff the value has changed, i.e. iff the call must be sent to the driver.
+template<typename T>
+auto update(T& cached_value, T const& new_value) -> bool
+{
+    auto const changed = cached_value != new_value;
+    internal::state_cache_record_call(!changed);
+    cached_value = new_value;
+    return changed;
+}
+
+auto binding_of_unit(std::vector<GLuint>& bindings, GLuint unit) -> GLuint&
+{
+    if (unit >= bindings.size())
+        bindings.resize(unit + 1, unknown);
+    return bindings[unit];
+}
+
+void forget_binding(std::vector<GLuint>& bindings, GLuint object)
+{
+    // OpenGL reverts the units where the object was bound to 0
+    std::replace(bindings.begin(), bindings.end(), object, GLuint{0});
+}
+
+void set_active_texture_unit(GLuint unit)
+{
+    if (update(state().active_texture_unit, unit))
+        glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+} // namespace
+
+namespace StateCache {
+
+void use_program(GLuint program)
+{
+    if (update(state().program, program))
+        glUseProgram(program);
+}
+
+void bind_vertex_array(GLuint vertex_array)
+{
+    if (update(state().vertex_array, vertex_array))
+        glBindVertexArray(vertex_array);
+}
+
+void bind_texture(GLuint unit, GLuint texture)
+{
+    if (!update(binding_of_unit(state().textures, unit), texture))
+        return;
+    if (internal::supports_direct_state_access())
+    {
+        internal::gl_extensions().BindTextureUnit(unit, texture);
+        return;
+    }
+    set_active_texture_unit(unit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+void bind_sampler(GLuint unit, GLuint sampler)
+{
+    if (update(binding_of_unit(state().samplers, unit), sampler))
+        glBindSampler(unit, sampler);
+}
+
+void set_enabled(GLenum capability, bool enabled)
+{
+    auto& cached_value = state().capabilities.try_emplace(capability, unknown).first->second;
+    if (!update(cached_value, static_cast<GLuint>(enabled)))
+        return;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void set_blend_function(GLenum source_rgb, GLenum destination_rgb, GLenum source_alpha, GLenum destination_alpha)
+{
+    if (update(state().blend_function, {source_rgb, destination_rgb, source_alpha, destination_alpha}))
+        glBlendFuncSeparate(source_rgb, destination_rgb, source_alpha, destination_alpha);
+}
+
+void set_depth_function(GLenum function)
+{
+    if (update(state().depth_function, function))
+        glDepthFunc(function);
+}
+
+void set_depth_mask(bool write_depth)
+{
+    if (update(state().depth_mask, static_cast<GLuint>(write_depth)))
+        glDepthMask(write_depth ? GL_TRUE : GL_FALSE);
+}
+
+void invalidate()
+{
+    auto fresh_state           = State{};
+    fresh_state.generation     = state().generation + 1;
+    fresh_state.current_frame  = state().current_frame;
+    fresh_state.previous_frame = state().previous_frame;
+    state()                    = std::move(fresh_state);
+}
+
+auto counters() -> StateCacheCounters
+{
+    return state().previous_frame;
+}
+
+} // namespace StateCache
+
+namespace internal {
+
+void bind_texture_for_editing(GLuint texture)
+{
+    set_active_texture_unit(0); // Even if the texture is already bound to unit 0, unit 0 might not be the active one
+    StateCache::bind_texture(0, texture);
+}
+
+void state_cache_forget_program(GLuint program)
+{
+    // The program stays in use until another one is bound, but better safe than sorry
+    if (state().program == program)
+        state().program = unknown;
+}
+
+void state_cache_forget_vertex_array(GLuint vertex_array)
+{
+    if (state().vertex_array == vertex_array)
+        state().vertex_array = 0;
+}
+
+void state_cache_forget_texture(GLuint texture)
+{
+    forget_binding(state().textures, texture);
+}
+
+void state_cache_forget_sampler(GLuint sampler)
+{
+    forget_binding(state().samplers, sampler);
+}
+
+void state_cache_record_call(bool elided)
+{
+    auto& counters = state().current_frame;
+    if (elided)
+        counters.elided_calls++;
+    else
+        counters.issued_calls++;
+}
+
+auto state_cache_generation() -> uint64_t
+{
+    return state().generation;
+}
+
+void state_cache_next_frame()
+{
+    state().previous_frame = std::exchange(state().current_frame, {});
+}
+
+} // namespace internal
+
+} // namespace gl
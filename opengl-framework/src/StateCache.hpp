@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "glad/gl.h"
+
+namespace gl {
+
+struct StateCacheCounters {
+    /// Calls that have been sent to the driver.
+    size_t issued_calls{};
+    /// Calls that have been skipped, because they would have set a state to the value it already had.
+    size_t elided_calls{};
+};
+
+/// Remembers the state that has been set through it, and skips the calls that wouldn't change anything.
+/// Driver calls are not free (validation, and sometimes a round-trip to another thread), so this saves a lot when you re-bind the same things every frame.
+/// The whole framework goes through it (Shader::bind(), Shader::set_uniform(), Mesh::draw(), etc.), and you should use it too instead of calling glEnable(), glBlendFunc(), etc. directly.
+/// If you do change the state behind its back, call invalidate() so that it doesn't skip calls that are actually needed.
+namespace StateCache {
+
+void use_program(GLuint program);
+void bind_vertex_array(GLuint vertex_array);
+/// Binds a GL_TEXTURE_2D to the given texture unit.
+void bind_texture(GLuint unit, GLuint texture);
+void bind_sampler(GLuint unit, GLuint sampler);
+
+/// e.g. `set_enabled(GL_DEPTH_TEST, true)`, `set_enabled(GL_BLEND, false)`
+void set_enabled(GLenum capability, bool enabled);
+void set_blend_function(GLenum source_rgb, GLenum destination_rgb, GLenum source_alpha, GLenum destination_alpha);
+void set_depth_function(GLenum function);
+void set_depth_mask(bool write_depth);
+
+/// Forgets everything, so that the next calls are sent to the driver no matter what. Also forgets the values of the uniforms of all the shaders.
+void invalidate();
+
+/// The counts for the previous frame. Use them to check that you are not issuing more calls than you should.
+auto counters() -> StateCacheCounters;
+
+} // namespace StateCache
+
+namespace internal {
+
+/// Binds the texture to the active texture unit, to edit it with glTexImage2D(), glTexParameteri(), etc.
+/// Always uses texture unit 0, which Shader::set_uniform() doesn't use for rendering when textures have to be bound to be edited.
+void bind_texture_for_editing(GLuint texture);
+
+/// Must be called when an object is deleted, because OpenGL unbinds it, and its name can then be reused by a new object that isn't bound.
+void state_cache_forget_program(GLuint program);
+void state_cache_forget_vertex_array(GLuint vertex_array);
+void state_cache_forget_texture(GLuint texture);
+void state_cache_forget_sampler(GLuint sampler);
+
+/// For the things that are cached elsewhere (e.g. the values of the uniforms, that each Shader stores), so that they appear in the counters too.
+void state_cache_record_call(bool elided);
+/// Changes each time StateCache::invalidate() is called. The caches that live outside of StateCache must be cleared when it changes.
+auto state_cache_generation() -> uint64_t;
+
+/// Called by gl::window_is_open() at the end of each frame.
+void state_cache_next_frame();
+
+} // namespace internal
+
+} // namespace gl
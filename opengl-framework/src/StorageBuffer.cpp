@@ -0,0 +1,61 @@
+#include "StorageBuffer.hpp"
+#include <utility>
+
+namespace gl::internal {
+
+UntypedStorageBuffer::UntypedStorageBuffer(size_t size_in_bytes, std::span<std::byte const> data)
+    : _size_in_bytes{size_in_bytes}
+{
+    assert((data.empty() || data.size() == size_in_bytes) && "The data doesn't match the size of the buffer.");
+    glGenBuffers(1, &_id);
+    // Uses the copy target so that we don't mess with the state of whatever buffer is currently bound
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size_in_bytes), data.empty() ? nullptr : data.data(), GL_DYNAMIC_DRAW);
+    if (data.empty())
+        glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R8, GL_RED, GL_UNSIGNED_BYTE, nullptr); // Without data, it clears with zeros
+}
+
+void UntypedStorageBuffer::upload(std::span<std::byte const> data, size_t offset_in_bytes)
+{
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+void UntypedStorageBuffer::download(std::span<std::byte> data, size_t offset_in_bytes) const
+{
+    glBindBuffer(GL_COPY_READ_BUFFER, _id);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, static_cast<GLintptr>(offset_in_bytes), static_cast<GLsizeiptr>(data.size()), data.data());
+}
+
+void UntypedStorageBuffer::bind(GLuint binding) const
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, _id);
+}
+
+void UntypedStorageBuffer::release_gpu_resources()
+{
+    glDeleteBuffers(1, &_id);
+}
+
+UntypedStorageBuffer::~UntypedStorageBuffer()
+{
+    release_gpu_resources();
+}
+
+UntypedStorageBuffer::UntypedStorageBuffer(UntypedStorageBuffer&& o) noexcept
+    : _id{std::exchange(o._id, 0)}
+    , _size_in_bytes{std::exchange(o._size_in_bytes, 0)}
+{}
+
+auto UntypedStorageBuffer::operator=(UntypedStorageBuffer&& o) noexcept -> UntypedStorageBuffer&
+{
+    if (this != &o)
+    {
+        release_gpu_resources();
+        _id            = std::exchange(o._id, 0);
+        _size_in_bytes = std::exchange(o._size_in_bytes, 0);
+    }
+    return *this;
+}
+
+} // namespace gl::internal
@@ -0,0 +1,94 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "glad/gl.h"
+
+namespace gl {
+
+namespace internal {
+
+/// The part of StorageBuffer<T> that doesn't depend on T.
+class UntypedStorageBuffer {
+public:
+    /// If `data` is empty, the buffer is filled with zeros.
+    UntypedStorageBuffer(size_t size_in_bytes, std::span<std::byte const> data);
+    ~UntypedStorageBuffer();
+    UntypedStorageBuffer(UntypedStorageBuffer const&)                    = delete;
+    auto operator=(UntypedStorageBuffer const&) -> UntypedStorageBuffer& = delete;
+    UntypedStorageBuffer(UntypedStorageBuffer&&) noexcept;
+    auto operator=(UntypedStorageBuffer&&) noexcept -> UntypedStorageBuffer&;
+
+    void upload(std::span<std::byte const> data, size_t offset_in_bytes);
+    void download(std::span<std::byte> data, size_t offset_in_bytes) const;
+    void bind(GLuint binding) const;
+
+    auto id() const -> GLuint { return _id; }
+    auto size_in_bytes() const -> size_t { return _size_in_bytes; }
+
+private:
+    void release_gpu_resources();
+
+private:
+    GLuint _id{};
+    size_t _size_in_bytes{};
+};
+
+} // namespace internal
+
+/// An array of T that lives on the GPU, that shaders can read and write (a.k.a. a Shader Storage Buffer Object).
+/// Bind it with bind(), and declare it in your shader with the same binding, e.g. for a `StorageBuffer<Particle>` bound to 0:
+/// ```glsl
+/// layout(std430, binding = 0) buffer Particles {
+///     Particle particles[];
+/// };
+/// ```
+/// T must have the same layout as its declaration in the shader, which follows the std430 rules. Beware of the vec3s: they are aligned like vec4s, so either use vec4s or add some padding.
+/// You can also use it as a vertex, instance or indirect buffer, through its id().
+template<typename T>
+class StorageBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "The elements are copied as raw bytes to the GPU.");
+
+public:
+    /// Filled with zeros.
+    explicit StorageBuffer(size_t elements_count)
+        : _buffer{elements_count * sizeof(T), {}}
+    {}
+    explicit StorageBuffer(std::span<T const> elements)
+        : _buffer{elements.size_bytes(), std::as_bytes(elements)}
+    {}
+
+    /// Replaces the elements starting at `first_element`.
+    void upload(std::span<T const> elements, size_t first_element = 0)
+    {
+        assert(first_element + elements.size() <= size() && "Trying to upload more elements than the buffer can hold.");
+        _buffer.upload(std::as_bytes(elements), first_element * sizeof(T));
+    }
+
+    /// Reads the elements back from the GPU. This waits for all the commands that write to the buffer to be done, so don't do it every frame!
+    /// Call memory_barrier(Barrier::Readback) first if they were written by a shader.
+    auto download() const -> std::vector<T>
+    {
+        auto elements = std::vector<T>(size());
+        download(elements);
+        return elements;
+    }
+    void download(std::span<T> elements, size_t first_element = 0) const
+    {
+        assert(first_element + elements.size() <= size() && "Trying to download more elements than the buffer holds.");
+        _buffer.download(std::as_writable_bytes(elements), first_element * sizeof(T));
+    }
+
+    /// Binds the buffer to the binding point that your shader declares with `layout(std430, binding = ...) buffer`.
+    void bind(GLuint binding) const { _buffer.bind(binding); }
+
+    auto size() const -> size_t { return _buffer.size_in_bytes() / sizeof(T); }
+    auto id() const -> GLuint { return _buffer.id(); }
+
+private:
+    internal::UntypedStorageBuffer _buffer;
+};
+
+} // namespace gl
@@ -1,36 +1,74 @@
 #include "Texture.hpp"
 #include <cassert>
-#include "glm/gtc/type_ptr.hpp"
-#include "img/img.hpp"
+#include <optional>
+#include "load_image.hpp"
 #include "make_absolute_path.hpp"
 
 namespace gl {
 
-static void upload_image_data(TextureSource::Pixels const& source)
+/// glTextureStorage2D() only accepts sized formats, so for the unsized ones we pick the format that drivers usually pick themselves.
+static auto sized_format(InternalFormat format) -> std::optional<GLenum>
 {
+    switch (format)
+    {
+    case InternalFormat::R:
+        return GL_R8;
+    case InternalFormat::RG:
+        return GL_RG8;
+    case InternalFormat::RGB:
+        return GL_RGB8;
+    case InternalFormat::RGBA:
+        return GL_RGBA8;
+    case InternalFormat::Depth:
+        return GL_DEPTH_COMPONENT24;
+    case InternalFormat::DepthStencil:
+        return GL_DEPTH24_STENCIL8;
+    case InternalFormat::Compressed_R:
+    case InternalFormat::Compressed_RG:
+    case InternalFormat::Compressed_RGB:
+    case InternalFormat::Compressed_RGBA:
+    case InternalFormat::Compressed_SRGB:
+    case InternalFormat::Compressed_SRGB_ALPHA:
+        return std::nullopt; // The driver chooses the compression when it receives the pixels, we can't know it in advance
+    default:
+        return static_cast<GLenum>(format);
+    }
+}
+
+static void upload_image_data(GLuint texture_id, TextureSource::Pixels const& source)
+{
+    auto const format = sized_format(source.texture_format);
+    if (internal::supports_direct_state_access() && format.has_value())
+    {
+        internal::gl_extensions().TextureStorage2D(texture_id, 1, *format, source.width, source.height);
+        internal::gl_extensions().TextureSubImage2D(texture_id, 0, 0, 0, source.width, source.height, static_cast<GLenum>(source.source_pixels_format), static_cast<GLenum>(source.source_pixels_type), source.pixels.data());
+        return;
+    }
+    internal::bind_texture_for_editing(texture_id);
     glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(source.texture_format), source.width, source.height, 0, static_cast<GLenum>(source.source_pixels_format), static_cast<GLenum>(source.source_pixels_type), source.pixels.data());
 }
 
-static void upload_image_data(TextureSource::EmptyImage const& source)
+static void upload_image_data(GLuint texture_id, TextureSource::EmptyImage const& source)
 {
-    glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLint>(source.texture_format), source.width, source.height);
+    if (internal::supports_direct_state_access())
+    {
+        internal::gl_extensions().TextureStorage2D(texture_id, 1, static_cast<GLenum>(source.texture_format), source.width, source.height);
+        return;
+    }
+    internal::bind_texture_for_editing(texture_id);
+    glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(source.texture_format), source.width, source.height);
 }
 
-static void upload_image_data(TextureSource::File const& source)
+static void upload_image_data(GLuint texture_id, TextureSource::File const& source)
 {
-    auto const image = img::load(make_absolute_path(source.path), 4, source.flip_y);
-    upload_image_data(TextureSource::Pixels{.pixels = image.data_span(), .width = static_cast<GLsizei>(image.width()), .height = static_cast<GLsizei>(image.height()), .source_pixels_type = Type::UnsignedByte, .source_pixels_format = Format::RGBA, .texture_format = source.texture_format});
+    auto const image = internal::load_image(make_absolute_path(source.path), source.flip_y);
+    upload_image_data(texture_id, TextureSource::Pixels{.pixels = image.data_span(), .width = static_cast<GLsizei>(image.width()), .height = static_cast<GLsizei>(image.height()), .source_pixels_type = Type::UnsignedByte, .source_pixels_format = Format::RGBA, .texture_format = source.texture_format});
 }
 
 Texture::Texture(AnyTextureSource const& source, TextureOptions const& options)
+    : _options{options}
 {
-    glBindTexture(GL_TEXTURE_2D, _id.id());
-    std::visit([&](auto&& source) { upload_image_data(source); }, source);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(options.minification_filter));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(options.magnification_filter));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, static_cast<GLint>(options.wrap_x));
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, static_cast<GLint>(options.wrap_y));
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(options.border_color));
+    std::visit([&](auto&& source) { upload_image_data(_id.id(), source); }, source);
 }
 
-} // namespace gl
\ No newline at end of file
+} // namespace gl
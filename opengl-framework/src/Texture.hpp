@@ -2,6 +2,8 @@
 #include <filesystem>
 #include <span>
 #include <variant>
+#include "StateCache.hpp"
+#include "gl_extensions.hpp"
 #include "glad/gl.h"
 #include "glm/glm.hpp"
 
@@ -303,10 +305,14 @@ class UniqueTexture {
 public:
     UniqueTexture() // NOLINT(*-member-init)
     {
-        glGenTextures(1, &_id);
+        if (supports_direct_state_access())
+            gl_extensions().CreateTextures(GL_TEXTURE_2D, 1, &_id);
+        else
+            glGenTextures(1, &_id);
     }
     ~UniqueTexture()
     {
+        state_cache_forget_texture(_id);
         glDeleteTextures(1, &_id);
     }
     UniqueTexture(UniqueTexture const&)                    = delete; // You cannot copy
@@ -320,6 +326,7 @@ public:
     {
         if (&o != this)
         {
+            state_cache_forget_texture(_id);
             glDeleteTextures(1, &_id);
             _id   = o._id;
             o._id = 0;
@@ -366,16 +373,22 @@ struct TextureOptions {
     Wrap      wrap_x{Wrap::ClampToEdge};
     Wrap      wrap_y{Wrap::ClampToEdge};
     glm::vec4 border_color{0.f}; // Only used when at least one of the Wrap is set to ClampToBorder
+
+    friend auto operator==(TextureOptions const&, TextureOptions const&) -> bool = default;
 };
 
 class Texture {
 public:
+    /// The options are not stored in the texture itself, but in a sampler shared by all the textures that use the same options (see TextureSamplerLibrary).
+    /// Shader::set_uniform() binds it for you.
     explicit Texture(AnyTextureSource const&, TextureOptions const& = {});
 
     auto id() const -> GLuint { return _id.id(); }
+    auto options() const -> TextureOptions const& { return _options; }
 
 private:
     internal::UniqueTexture _id{};
+    TextureOptions          _options{};
 };
 
 } // namespace gl
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "TextureSampler.hpp"
+#include <utility>
+#include "glm/gtc/type_ptr.hpp"
+#include "hash.hpp"
+
+namespace gl {
+
+TextureSampler::TextureSampler(TextureOptions const& options)
+{
+    glGenSamplers(1, &_id);
+    glSamplerParameteri(_id, GL_TEXTURE_MIN_FILTER, static_cast<GLint>(options.minification_filter));
+    glSamplerParameteri(_id, GL_TEXTURE_MAG_FILTER, static_cast<GLint>(options.magnification_filter));
+    glSamplerParameteri(_id, GL_TEXTURE_WRAP_S, static_cast<GLint>(options.wrap_x));
+    glSamplerParameteri(_id, GL_TEXTURE_WRAP_T, static_cast<GLint>(options.wrap_y));
+    glSamplerParameterfv(_id, GL_TEXTURE_BORDER_COLOR, glm::value_ptr(options.border_color));
+}
+
+void TextureSampler::release_gpu_resources()
+{
+    internal::state_cache_forget_sampler(_id);
+    glDeleteSamplers(1, &_id);
+}
+
+TextureSampler::~TextureSampler()
+{
+    release_gpu_resources();
+}
+
+TextureSampler::TextureSampler(TextureSampler&& o) noexcept
+    : _id{std::exchange(o._id, 0)}
+{}
+
+auto TextureSampler::operator=(TextureSampler&& o) noexcept -> TextureSampler&
+{
+    if (this != &o)
+    {
+        release_gpu_resources();
+        _id = std::exchange(o._id, 0);
+    }
+    return *this;
+}
+
+auto TextureSamplerLibrary::instance() -> TextureSamplerLibrary&
+{
+    static auto instance = TextureSamplerLibrary{};
+    return instance;
+}
+
+auto TextureSamplerLibrary::get(TextureOptions const& options) -> TextureSampler const&
+{
+    auto it = _samplers.find(options);
+    if (it == _samplers.end())
+        it = _samplers.emplace(options, TextureSampler{options}).first;
+    return it->second;
+}
+
+auto TextureSamplerLibrary::OptionsHash::operator()(TextureOptions const& options) const noexcept -> size_t
+{
+    auto hash = internal::hash_bytes(std::as_bytes(std::span{glm::value_ptr(options.border_color), 4}));
+    for (auto const value : {static_cast<GLint>(options.minification_filter), static_cast<GLint>(options.magnification_filter), static_cast<GLint>(options.wrap_x), static_cast<GLint>(options.wrap_y)})
+        hash = internal::hash_combine(hash, static_cast<uint64_t>(value));
+    return static_cast<size_t>(hash);
+}
+
+} // namespace gl
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+#include "Texture.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+/// The filtering and wrapping options, stored separately from the textures so that all the textures that use the same options can share them.
+class TextureSampler {
+public:
+    explicit TextureSampler(TextureOptions const&);
+    ~TextureSampler();
+    TextureSampler(TextureSampler const&)                    = delete;
+    auto operator=(TextureSampler const&) -> TextureSampler& = delete;
+    TextureSampler(TextureSampler&&) noexcept;
+    auto operator=(TextureSampler&&) noexcept -> TextureSampler&;
+
+    auto id() const -> GLuint { return _id; }
+
+private:
+    void release_gpu_resources();
+
+private:
+    GLuint _id{};
+};
+
+/// Creates each sampler the first time some options are used, and then shares it with all the textures that use the same options.
+/// Shader::set_uniform() uses it for you, you only need it if you bind textures yourself.
+class TextureSamplerLibrary {
+public:
+    static auto instance() -> TextureSamplerLibrary&;
+
+    auto get(TextureOptions const&) -> TextureSampler const&;
+
+private:
+    struct OptionsHash {
+        auto operator()(TextureOptions const&) const noexcept -> size_t;
+    };
+
+private:
+    std::unordered_map<TextureOptions, TextureSampler, OptionsHash> _samplers{};
+};
+
+} // namespace gl
@@ -0,0 +1,49 @@
+#include "ThreadPool.hpp"
+
+namespace gl::internal {
+
+ThreadPool::ThreadPool(size_t threads_count)
+{
+    _threads.reserve(threads_count);
+    for (size_t i = 0; i < threads_count; ++i)
+        _threads.emplace_back([this]() { worker_loop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        auto const lock = std::lock_guard{_mutex};
+        _is_stopping    = true;
+    }
+    _condition.notify_all();
+    for (auto& thread : _threads)
+        thread.join();
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        auto const lock = std::lock_guard{_mutex};
+        _jobs.push_back(std::move(job));
+    }
+    _condition.notify_one();
+}
+
+void ThreadPool::worker_loop()
+{
+    while (true)
+    {
+        auto job = std::function<void()>{};
+        {
+            auto lock = std::unique_lock{_mutex};
+            _condition.wait(lock, [&]() { return _is_stopping || !_jobs.empty(); });
+            if (_is_stopping)
+                return;
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+        job();
+    }
+}
+
+} // namespace gl::internal
@@ -0,0 +1,34 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gl::internal {
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads_count);
+    ~ThreadPool();
+    ThreadPool(ThreadPool const&)                    = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+    ThreadPool(ThreadPool&&)                         = delete;
+    auto operator=(ThreadPool&&) -> ThreadPool&      = delete;
+
+    /// The job will be run on one of the worker threads. Jobs that are still pending when the pool is destroyed are never run.
+    void submit(std::function<void()> job);
+
+private:
+    void worker_loop();
+
+private:
+    std::mutex                        _mutex{};
+    std::condition_variable           _condition{};
+    std::deque<std::function<void()>> _jobs{};
+    bool                              _is_stopping{false};
+    std::vector<std::thread>          _threads{};
+};
+
+} // namespace gl::internal
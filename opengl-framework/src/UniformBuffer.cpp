@@ -0,0 +1,187 @@
+#include "UniformBuffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <optional>
+#include <utility>
+#include "gl_extensions.hpp"
+#include "handle_error.hpp"
+
+namespace gl {
+
+namespace {
+
+auto supports_persistent_mapping() -> bool
+{
+    return internal::gl_extensions().BufferStorage != nullptr;
+}
+
+auto uniform_buffer_offset_alignment() -> size_t
+{
+    GLint alignment{};
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    return static_cast<size_t>(std::max(alignment, 1));
+}
+
+auto round_up(size_t value, size_t alignment) -> size_t
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Created the first time they are used, so that they don't cost anything to the programs that don't use them
+auto frame_uniforms_buffer() -> std::optional<UniformRingBuffer>&
+{
+    static auto instance = std::optional<UniformRingBuffer>{};
+    return instance;
+}
+
+auto object_uniforms_buffer() -> std::optional<UniformRingBuffer>&
+{
+    static auto instance = std::optional<UniformRingBuffer>{};
+    return instance;
+}
+
+} // namespace
+
+UniformRingBuffer::UniformRingBuffer(UniformRingBuffer_Descriptor const& desc)
+    : _desc{desc}
+    , _offset_alignment{uniform_buffer_offset_alignment()}
+{
+    _desc.segment_size_in_bytes = round_up(_desc.segment_size_in_bytes, _offset_alignment); // So that each segment starts on an aligned offset
+
+    glGenBuffers(1, &_id);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+    auto const size = static_cast<GLsizeiptr>(segments_count * _desc.segment_size_in_bytes);
+    if (!supports_persistent_mapping())
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        return;
+    }
+    // The mapping is coherent, so our writes are visible to the GPU without having to flush them explicitly
+    auto const flags = GLbitfield{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT};
+    internal::gl_extensions().BufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+    _mapped_data = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+}
+
+void UniformRingBuffer::wait_for_segment(size_t segment_index)
+{
+    auto& fence = _fences[segment_index];
+    if (fence == nullptr)
+        return;
+    // The fence was inserted two frames ago, so in practice the GPU is done with it and we don't actually wait
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, std::numeric_limits<GLuint64>::max()) == GL_TIMEOUT_EXPIRED) {}
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void UniformRingBuffer::move_to_next_segment()
+{
+    // All the commands issued so far (including the draws that read the current segment) must be done before we write into this segment again
+    _fences[_current_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    _current_segment          = (_current_segment + 1) % segments_count;
+    _offset_in_segment        = 0;
+    wait_for_segment(_current_segment);
+}
+
+void UniformRingBuffer::next_frame()
+{
+    if (_offset_in_segment == 0) // Nothing has been pushed during this frame
+        return;
+    move_to_next_segment();
+}
+
+void UniformRingBuffer::push(std::span<std::byte const> data)
+{
+    if (data.size() > _desc.segment_size_in_bytes)
+        handle_error(std::format("[UniformRingBuffer] Can't push {} bytes, the segments are only {} bytes. Increase UniformRingBuffer_Descriptor::segment_size_in_bytes.", data.size(), _desc.segment_size_in_bytes));
+    if (_offset_in_segment + data.size() > _desc.segment_size_in_bytes)
+        move_to_next_segment();
+
+    auto const offset = _current_segment * _desc.segment_size_in_bytes + _offset_in_segment;
+    if (is_persistently_mapped())
+    {
+        std::memcpy(_mapped_data + offset, data.data(), data.size()); // NOLINT(*pointer-arithmetic)
+    }
+    else
+    {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, _id);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(data.size()), data.data());
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, _desc.binding, _id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(data.size()));
+    _offset_in_segment = round_up(_offset_in_segment + data.size(), _offset_alignment);
+}
+
+void UniformRingBuffer::release_gpu_resources()
+{
+    for (auto& fence : _fences)
+    {
+        glDeleteSync(fence); // Silently ignores nullptr
+        fence = nullptr;
+    }
+    glDeleteBuffers(1, &_id); // Also unmaps the buffer
+}
+
+UniformRingBuffer::~UniformRingBuffer()
+{
+    release_gpu_resources();
+}
+
+UniformRingBuffer::UniformRingBuffer(UniformRingBuffer&& o) noexcept
+    : _desc{o._desc}
+    , _offset_alignment{o._offset_alignment}
+    , _id{std::exchange(o._id, 0)}
+    , _mapped_data{std::exchange(o._mapped_data, nullptr)}
+    , _fences{std::exchange(o._fences, {})}
+    , _current_segment{o._current_segment}
+    , _offset_in_segment{o._offset_in_segment}
+{}
+
+auto UniformRingBuffer::operator=(UniformRingBuffer&& o) noexcept -> UniformRingBuffer&
+{
+    if (this != &o)
+    {
+        // Delete this
+        release_gpu_resources();
+
+        // Move
+        _desc              = o._desc;
+        _offset_alignment  = o._offset_alignment;
+        _id                = std::exchange(o._id, 0);
+        _mapped_data       = std::exchange(o._mapped_data, nullptr);
+        _fences            = std::exchange(o._fences, {});
+        _current_segment   = o._current_segment;
+        _offset_in_segment = o._offset_in_segment;
+    }
+    return *this;
+}
+
+void set_frame_uniforms(FrameUniforms const& uniforms)
+{
+    auto& buffer = frame_uniforms_buffer();
+    if (!buffer)
+        buffer.emplace(UniformRingBuffer_Descriptor{.binding = UniformBinding::Frame, .segment_size_in_bytes = 16 * 1024});
+    buffer->push(uniforms);
+}
+
+void set_object_uniforms(ObjectUniforms const& uniforms)
+{
+    auto& buffer = object_uniforms_buffer();
+    if (!buffer)
+        buffer.emplace(UniformRingBuffer_Descriptor{.binding = UniformBinding::Object});
+    buffer->push(uniforms);
+}
+
+namespace internal {
+
+void uniform_buffers_next_frame()
+{
+    if (auto& buffer = frame_uniforms_buffer())
+        buffer->next_frame();
+    if (auto& buffer = object_uniforms_buffer())
+        buffer->next_frame();
+}
+
+} // namespace internal
+
+} // namespace gl
@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <span>
+#include "glad/gl.h"
+#include "glm/glm.hpp"
+
+namespace gl {
+
+/// Binding points reserved by the framework. Every Shader connects its `FrameUniforms` and `ObjectUniforms` blocks to them automatically, so you never have to call glUniformBlockBinding() yourself.
+namespace UniformBinding {
+inline constexpr GLuint Frame  = 0;
+inline constexpr GLuint Object = 1;
+} // namespace UniformBinding
+
+/// The data shared by all the draws of a frame. Upload it once per frame with set_frame_uniforms().
+/// It follows the std140 rules (only vec4s and mat4s, and scalars packed by 4), so in your shaders you can declare it as:
+/// ```glsl
+/// layout(std140) uniform FrameUniforms {
+///     mat4  view;
+///     mat4  projection;
+///     mat4  view_projection;
+///     vec4  camera_position;
+///     vec4  light_direction;
+///     vec4  light_color;
+///     float time;
+///     float delta_time;
+///     vec2  framebuffer_size;
+/// } frame;
+/// ```
+/// and use it as `frame.view_projection`. If several stages of a shader declare it, the declarations must be identical.
+struct FrameUniforms {
+    glm::mat4 view{1.f};
+    glm::mat4 projection{1.f};
+    glm::mat4 view_projection{1.f};
+    glm::vec4 camera_position{0.f};                 // w is unused
+    glm::vec4 light_direction{0.f, 0.f, -1.f, 0.f}; // w is unused
+    glm::vec4 light_color{1.f};
+    float     time{};
+    float     delta_time{};
+    glm::vec2 framebuffer_size{};
+};
+static_assert(sizeof(FrameUniforms) == 256, "FrameUniforms must match its std140 layout");
+
+/// The data of a single draw. Set it before each draw with set_object_uniforms(). In your shaders, declare it as:
+/// ```glsl
+/// layout(std140) uniform ObjectUniforms {
+///     mat4 transform;
+///     mat4 normal_matrix;
+/// } object;
+/// ```
+struct ObjectUniforms {
+    glm::mat4 transform{1.f};
+    /// Use it to transform your normals, and set it to `glm::inverse(glm::transpose(transform))`. It only differs from the transform when there is a non-uniform scale.
+    glm::mat4 normal_matrix{1.f};
+};
+static_assert(sizeof(ObjectUniforms) == 128, "ObjectUniforms must match its std140 layout");
+
+/// Uploads the data to the next free part of a uniform buffer managed by the framework, and binds it: all the draws issued after that will see it.
+/// You can call it several times per frame (e.g. once for a shadow pass and once for the main pass).
+void set_frame_uniforms(FrameUniforms const&);
+/// Replaces a `uniform mat4 _transform;` that you would set with Shader::set_uniform() before each draw.
+void set_object_uniforms(ObjectUniforms const&);
+
+struct UniformRingBuffer_Descriptor {
+    /// The binding point that the data is bound to, i.e. the one your block is connected to.
+    GLuint binding{};
+    /// The buffer is split into 3 parts of this size, used one after the other. When one is full we move on to the next one, so this is not a hard limit, but it should be big enough to hold a frame worth of data.
+    size_t segment_size_in_bytes{256 * 1024};
+};
+
+/// A uniform buffer that receives new data many times per frame, without ever overwriting data that the GPU is still reading.
+/// Each push() writes to the next free slot, and binds that slot with glBindBufferRange(). Binding a different range of the same buffer is much cheaper than uploading a bunch of glUniform*() before each draw.
+/// When available (OpenGL 4.4) the buffer is persistently mapped, so that push() is a simple memcpy; otherwise we use glBufferSubData(). In both cases fences guarantee that a part is done being read before we write into it again.
+class UniformRingBuffer {
+public:
+    explicit UniformRingBuffer(UniformRingBuffer_Descriptor const&);
+    ~UniformRingBuffer();
+    UniformRingBuffer(UniformRingBuffer const&)                    = delete;
+    auto operator=(UniformRingBuffer const&) -> UniformRingBuffer& = delete;
+    UniformRingBuffer(UniformRingBuffer&&) noexcept;
+    auto operator=(UniformRingBuffer&&) noexcept -> UniformRingBuffer&;
+
+    /// Copies the data to the next free slot of the buffer, and binds that slot. The next draws will see this data.
+    void push(std::span<std::byte const> data);
+    template<typename Uniforms>
+    void push(Uniforms const& data)
+    {
+        push(std::as_bytes(std::span{&data, 1}));
+    }
+
+    /// Moves on to the next part of the buffer. Must be called once per frame (this is done by gl::window_is_open() for the buffers of the framework).
+    void next_frame();
+
+    auto id() const -> GLuint { return _id; }
+    /// True iff the buffer is persistently mapped.
+    auto is_persistently_mapped() const -> bool { return _mapped_data != nullptr; }
+
+private:
+    void move_to_next_segment();
+    void wait_for_segment(size_t segment_index);
+    void release_gpu_resources();
+
+private:
+    static constexpr size_t segments_count = 3;
+
+    UniformRingBuffer_Descriptor _desc;
+    size_t                       _offset_alignment;
+
+    GLuint     _id{};
+    std::byte* _mapped_data{}; // nullptr if we use glBufferSubData()
+
+    std::array<GLsync, segments_count> _fences{}; // Signaled when the GPU is done with the draws that use each segment
+    size_t                             _current_segment{};
+    size_t                             _offset_in_segment{};
+};
+
+namespace internal {
+/// Called by gl::window_is_open() at the end of each frame.
+void uniform_buffers_next_frame();
+} // namespace internal
+
+} // namespace gl
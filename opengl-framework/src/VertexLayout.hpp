@@ -0,0 +1,115 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Mesh.hpp"
+#include "gl_extensions.hpp"
+#include "glad/gl.h"
+
+namespace gl {
+
+/// A vertex layout known at compile time, e.g. `gl::VertexLayout<gl::VertexAttribute::Position3D, gl::VertexAttribute::UV, gl::VertexAttribute::Normal3D>`.
+/// The stride and the offsets are computed by the compiler, and setting up the vertex array doesn't involve any std::variant nor any allocation.
+/// The attributes get consecutive locations, in the order in which you list them, starting at 0 (a matrix takes one location per column).
+/// Use it with Mesh{Layout{}, TypedMesh_Descriptor<Vertex>{...}}, which checks at compile time that your vertex struct matches the layout.
+template<typename... Attributes>
+class VertexLayout {
+public:
+    static constexpr size_t attributes_count = sizeof...(Attributes);
+
+    /// Size of one vertex, in bytes.
+    static constexpr GLsizei stride = (0 + ... + Attributes::size_in_bytes());
+
+    /// Location of each attribute in the shader.
+    static constexpr std::array<GLuint, attributes_count> locations = [] {
+        auto   res      = std::array<GLuint, attributes_count>{};
+        GLuint location = 0;
+        size_t i        = 0;
+        ((res[i++] = location, location += static_cast<GLuint>(Attributes::columns_count())), ...);
+        return res;
+    }();
+
+    /// Offset of each attribute, in bytes, from the beginning of the vertex.
+    /// You can use it to check your vertex struct: `static_assert(offsetof(MyVertex, uv) == Layout::offsets[1]);`
+    static constexpr std::array<size_t, attributes_count> offsets = [] {
+        auto   res    = std::array<size_t, attributes_count>{};
+        size_t offset = 0;
+        size_t i      = 0;
+        ((res[i++] = offset, offset += static_cast<size_t>(Attributes::size_in_bytes())), ...);
+        return res;
+    }();
+
+    /// True iff `Vertex` can be uploaded as is to a buffer with this layout.
+    template<typename Vertex>
+    static constexpr bool matches = sizeof(Vertex) == static_cast<size_t>(stride) && std::is_trivially_copyable_v<Vertex>;
+
+    /// Same as internal::set_vertex_attributes(), for the vertex buffer that is currently bound to GL_ARRAY_BUFFER.
+    static void set_vertex_attributes(GLuint divisor = 0)
+    {
+        set_vertex_attributes_impl(divisor, std::index_sequence_for<Attributes...>{});
+    }
+
+    /// Same, with Direct State Access: describes the layout of `buffer` to `vertex_array`, through the given binding index, without binding anything.
+    static void set_vertex_attributes(GLuint vertex_array, GLuint binding_index, GLuint buffer, GLuint divisor = 0)
+    {
+        auto const& ext = internal::gl_extensions();
+        ext.VertexArrayVertexBuffer(vertex_array, binding_index, buffer, 0, stride);
+        ext.VertexArrayBindingDivisor(vertex_array, binding_index, divisor);
+        set_vertex_attributes_impl(vertex_array, binding_index, std::index_sequence_for<Attributes...>{});
+    }
+
+    /// For the APIs that need a layout at runtime (DrawBatch, MeshArena, etc.).
+    static auto to_runtime_layout() -> std::vector<AnyVertexAttribute>
+    {
+        return to_runtime_layout_impl(std::index_sequence_for<Attributes...>{});
+    }
+
+private:
+    template<size_t... I>
+    static void set_vertex_attributes_impl(GLuint divisor, std::index_sequence<I...>)
+    {
+        (set_vertex_attribute<std::tuple_element_t<I, std::tuple<Attributes...>>>(locations[I], offsets[I], divisor), ...);
+    }
+
+    template<size_t... I>
+    static void set_vertex_attributes_impl(GLuint vertex_array, GLuint binding_index, std::index_sequence<I...>)
+    {
+        (set_vertex_attribute<std::tuple_element_t<I, std::tuple<Attributes...>>>(vertex_array, binding_index, locations[I], offsets[I]), ...);
+    }
+
+    template<typename Attribute>
+    static void set_vertex_attribute(GLuint location, size_t offset, GLuint divisor)
+    {
+        constexpr auto column_size = static_cast<size_t>(Attribute::size_in_bytes() / Attribute::columns_count());
+        for (GLuint column = 0; column < static_cast<GLuint>(Attribute::columns_count()); ++column) // Matrices use one location per column
+        {
+            glEnableVertexAttribArray(location + column);
+            glVertexAttribPointer(location + column, Attribute::size(), Attribute::type(), Attribute::normalized(), stride, reinterpret_cast<void const*>(offset + column * column_size)); // NOLINT(*reinterpret-cast, performance-no-int-to-ptr)
+            glVertexAttribDivisor(location + column, divisor);
+        }
+    }
+
+    template<typename Attribute>
+    static void set_vertex_attribute(GLuint vertex_array, GLuint binding_index, GLuint location, size_t offset)
+    {
+        auto const&    ext         = internal::gl_extensions();
+        constexpr auto column_size = static_cast<size_t>(Attribute::size_in_bytes() / Attribute::columns_count());
+        for (GLuint column = 0; column < static_cast<GLuint>(Attribute::columns_count()); ++column) // Matrices use one location per column
+        {
+            ext.EnableVertexArrayAttrib(vertex_array, location + column);
+            ext.VertexArrayAttribFormat(vertex_array, location + column, Attribute::size(), Attribute::type(), Attribute::normalized(), static_cast<GLuint>(offset + column * column_size));
+            ext.VertexArrayAttribBinding(vertex_array, location + column, binding_index);
+        }
+    }
+
+    template<size_t... I>
+    static auto to_runtime_layout_impl(std::index_sequence<I...>) -> std::vector<AnyVertexAttribute>
+    {
+        return {AnyVertexAttribute{Attributes{static_cast<int>(locations[I])}}...};
+    }
+};
+
+} // namespace gl
@@ -0,0 +1,104 @@
+#include "gl_extensions.hpp"
+#include <string_view>
+
+namespace gl::internal {
+
+namespace {
+
+auto extensions() -> GlExtensions&
+{
+    static auto instance = GlExtensions{};
+    return instance;
+}
+
+auto has_version(GLint major, GLint minor) -> bool
+{
+    GLint current_major{};
+    GLint current_minor{};
+    glGetIntegerv(GL_MAJOR_VERSION, &current_major);
+    glGetIntegerv(GL_MINOR_VERSION, &current_minor);
+    return current_major > major || (current_major == major && current_minor >= minor);
+}
+
+auto has_extension(std::string_view name) -> bool
+{
+    GLint count{};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        if (name == reinterpret_cast<char const*>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)))) // NOLINT(*reinterpret-cast)
+            return true;
+    }
+    return false;
+}
+
+template<typename Function>
+void load_function(Function& function, GLADloadfunc load, char const* name)
+{
+    function = reinterpret_cast<Function>(load(name)); // NOLINT(*reinterpret-cast)
+}
+
+} // namespace
+
+void load_gl_extensions(GLADloadfunc load)
+{
+    auto& ext = extensions();
+    ext       = {};
+    if (has_version(4, 4) || has_extension("GL_ARB_buffer_storage"))
+        load_function(ext.BufferStorage, load, "glBufferStorage");
+
+    if (has_extension("GL_KHR_parallel_shader_compile"))
+        load_function(ext.MaxShaderCompilerThreads, load, "glMaxShaderCompilerThreadsKHR");
+    else if (has_extension("GL_ARB_parallel_shader_compile"))
+        load_function(ext.MaxShaderCompilerThreads, load, "glMaxShaderCompilerThreadsARB");
+    if (ext.MaxShaderCompilerThreads != nullptr)
+    {
+        ext.MaxShaderCompilerThreads(0xFFFFFFFF); // Let the driver pick the number of threads
+        ext.parallel_shader_compile = true;
+    }
+
+    if (has_version(4, 5) || has_extension("GL_ARB_direct_state_access"))
+    {
+        auto       all_loaded        = true;
+        auto const load_dsa_function = [&](auto& function, char const* name) {
+            load_function(function, load, name);
+            all_loaded = all_loaded && function != nullptr;
+        };
+        load_dsa_function(ext.CreateBuffers, "glCreateBuffers");
+        load_dsa_function(ext.NamedBufferStorage, "glNamedBufferStorage");
+        load_dsa_function(ext.CreateVertexArrays, "glCreateVertexArrays");
+        load_dsa_function(ext.VertexArrayVertexBuffer, "glVertexArrayVertexBuffer");
+        load_dsa_function(ext.VertexArrayElementBuffer, "glVertexArrayElementBuffer");
+        load_dsa_function(ext.EnableVertexArrayAttrib, "glEnableVertexArrayAttrib");
+        load_dsa_function(ext.VertexArrayAttribFormat, "glVertexArrayAttribFormat");
+        load_dsa_function(ext.VertexArrayAttribBinding, "glVertexArrayAttribBinding");
+        load_dsa_function(ext.VertexArrayBindingDivisor, "glVertexArrayBindingDivisor");
+        load_dsa_function(ext.CreateTextures, "glCreateTextures");
+        load_dsa_function(ext.TextureStorage2D, "glTextureStorage2D");
+        load_dsa_function(ext.TextureSubImage2D, "glTextureSubImage2D");
+        load_dsa_function(ext.TextureParameteri, "glTextureParameteri");
+        load_dsa_function(ext.TextureParameterfv, "glTextureParameterfv");
+        load_dsa_function(ext.BindTextureUnit, "glBindTextureUnit");
+        load_dsa_function(ext.CreateFramebuffers, "glCreateFramebuffers");
+        load_dsa_function(ext.NamedFramebufferTexture, "glNamedFramebufferTexture");
+        load_dsa_function(ext.NamedFramebufferDrawBuffer, "glNamedFramebufferDrawBuffer");
+        load_dsa_function(ext.NamedFramebufferReadBuffer, "glNamedFramebufferReadBuffer");
+        load_dsa_function(ext.CheckNamedFramebufferStatus, "glCheckNamedFramebufferStatus");
+        load_dsa_function(ext.ClearNamedFramebufferfv, "glClearNamedFramebufferfv");
+        load_dsa_function(ext.ClearNamedFramebufferiv, "glClearNamedFramebufferiv");
+        load_dsa_function(ext.ClearNamedFramebufferfi, "glClearNamedFramebufferfi");
+        ext.direct_state_access = all_loaded;
+    }
+}
+
+auto gl_extensions() -> GlExtensions const&
+{
+    return extensions();
+}
+
+auto supports_direct_state_access() -> bool
+{
+    return extensions().direct_state_access;
+}
+
+} // namespace gl::internal
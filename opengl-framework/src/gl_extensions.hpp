@@ -0,0 +1,65 @@
+#pragma once
+#include "glad/gl.h"
+
+// glad has been generated for OpenGL 4.3 (we can't require anything more recent, since MacOS is stuck at 4.1), so the few more recent features we use are loaded by hand.
+// They are optional: always check that they are available before using them, and provide a fallback.
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace gl::internal {
+
+struct GlExtensions {
+    /// OpenGL 4.4, or ARB_buffer_storage
+    void(GLAD_API_PTR* BufferStorage)(GLenum target, GLsizeiptr size, void const* data, GLbitfield flags){nullptr};
+
+    /// KHR_parallel_shader_compile (or its ARB equivalent): the driver compiles the shaders on its own threads, and we can query GL_COMPLETION_STATUS_KHR without blocking.
+    /// True iff the extension is available (we have already called MaxShaderCompilerThreads to let the driver use as many threads as it wants).
+    bool parallel_shader_compile{false};
+    void(GLAD_API_PTR* MaxShaderCompilerThreads)(GLuint count){nullptr};
+
+    /// OpenGL 4.5, or ARB_direct_state_access: edit the objects without binding them first.
+    /// True iff all the functions below have been loaded.
+    bool direct_state_access{false};
+    void(GLAD_API_PTR* CreateBuffers)(GLsizei n, GLuint* buffers){nullptr};
+    void(GLAD_API_PTR* NamedBufferStorage)(GLuint buffer, GLsizeiptr size, void const* data, GLbitfield flags){nullptr};
+    void(GLAD_API_PTR* CreateVertexArrays)(GLsizei n, GLuint* arrays){nullptr};
+    void(GLAD_API_PTR* VertexArrayVertexBuffer)(GLuint vertex_array, GLuint binding_index, GLuint buffer, GLintptr offset, GLsizei stride){nullptr};
+    void(GLAD_API_PTR* VertexArrayElementBuffer)(GLuint vertex_array, GLuint buffer){nullptr};
+    void(GLAD_API_PTR* EnableVertexArrayAttrib)(GLuint vertex_array, GLuint index){nullptr};
+    void(GLAD_API_PTR* VertexArrayAttribFormat)(GLuint vertex_array, GLuint index, GLint size, GLenum type, GLboolean normalized, GLuint relative_offset){nullptr};
+    void(GLAD_API_PTR* VertexArrayAttribBinding)(GLuint vertex_array, GLuint index, GLuint binding_index){nullptr};
+    void(GLAD_API_PTR* VertexArrayBindingDivisor)(GLuint vertex_array, GLuint binding_index, GLuint divisor){nullptr};
+    void(GLAD_API_PTR* CreateTextures)(GLenum target, GLsizei n, GLuint* textures){nullptr};
+    void(GLAD_API_PTR* TextureStorage2D)(GLuint texture, GLsizei levels, GLenum internal_format, GLsizei width, GLsizei height){nullptr};
+    void(GLAD_API_PTR* TextureSubImage2D)(GLuint texture, GLint level, GLint x_offset, GLint y_offset, GLsizei width, GLsizei height, GLenum format, GLenum type, void const* pixels){nullptr};
+    void(GLAD_API_PTR* TextureParameteri)(GLuint texture, GLenum name, GLint param){nullptr};
+    void(GLAD_API_PTR* TextureParameterfv)(GLuint texture, GLenum name, GLfloat const* params){nullptr};
+    void(GLAD_API_PTR* BindTextureUnit)(GLuint unit, GLuint texture){nullptr};
+    void(GLAD_API_PTR* CreateFramebuffers)(GLsizei n, GLuint* framebuffers){nullptr};
+    void(GLAD_API_PTR* NamedFramebufferTexture)(GLuint framebuffer, GLenum attachment, GLuint texture, GLint level){nullptr};
+    void(GLAD_API_PTR* NamedFramebufferDrawBuffer)(GLuint framebuffer, GLenum buffer){nullptr};
+    void(GLAD_API_PTR* NamedFramebufferReadBuffer)(GLuint framebuffer, GLenum buffer){nullptr};
+    GLenum(GLAD_API_PTR* CheckNamedFramebufferStatus)(GLuint framebuffer, GLenum target){nullptr};
+    void(GLAD_API_PTR* ClearNamedFramebufferfv)(GLuint framebuffer, GLenum buffer, GLint draw_buffer, GLfloat const* value){nullptr};
+    void(GLAD_API_PTR* ClearNamedFramebufferiv)(GLuint framebuffer, GLenum buffer, GLint draw_buffer, GLint const* value){nullptr};
+    void(GLAD_API_PTR* ClearNamedFramebufferfi)(GLuint framebuffer, GLenum buffer, GLint draw_buffer, GLfloat depth, GLint stencil){nullptr};
+};
+
+/// Must be called once, right after glad has been loaded.
+void load_gl_extensions(GLADloadfunc load);
+/// The functions that are not supported by the driver are nullptr.
+auto gl_extensions() -> GlExtensions const&;
+
+/// When true, the objects are created and edited through Direct State Access, which doesn't change any binding behind your back.
+/// Otherwise we fall back to binding them to edit them (OpenGL 4.3, and 4.1 on MacOS).
+auto supports_direct_state_access() -> bool;
+
+} // namespace gl::internal
@@ -0,0 +1,26 @@
+#include "grow_buffer.hpp"
+#include <algorithm>
+
+namespace gl::internal {
+
+void grow_buffer(GLuint& buffer, size_t used_bytes, size_t new_capacity)
+{
+    GLuint new_buffer{};
+    glGenBuffers(1, &new_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(new_capacity), nullptr, GL_STATIC_DRAW);
+    if (used_bytes > 0)
+    {
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(used_bytes));
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer = new_buffer;
+}
+
+auto grown_capacity(size_t current_capacity, size_t required_capacity) -> size_t
+{
+    return std::max(required_capacity, current_capacity * 2);
+}
+
+} // namespace gl::internal
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include "glad/gl.h"
+
+namespace gl::internal {
+
+/// Replaces `buffer` with a bigger one, and copies the first `used_bytes` of the old one into it.
+/// Uses the copy targets so that we don't mess with the state of whatever vertex array is currently bound.
+void grow_buffer(GLuint& buffer, size_t used_bytes, size_t new_capacity);
+
+/// Grows exponentially, so that adding many small things doesn't copy the buffer each time.
+auto grown_capacity(size_t current_capacity, size_t required_capacity) -> size_t;
+
+} // namespace gl::internal
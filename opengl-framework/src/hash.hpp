@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string_view>
+
+namespace gl::internal {
+
+/// FNV-1a, 64 bits. Not cryptographic, but fast and stable across runs and platforms, so it can be stored on disk.
+inline auto hash_bytes(std::span<std::byte const> bytes, uint64_t seed = 14695981039346656037ull) -> uint64_t
+{
+    uint64_t hash = seed;
+    for (auto const byte : bytes)
+    {
+        hash ^= static_cast<uint64_t>(byte);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+inline auto hash_string(std::string_view str, uint64_t seed = 14695981039346656037ull) -> uint64_t
+{
+    return hash_bytes(std::as_bytes(std::span{str.data(), str.size()}), seed);
+}
+
+inline auto hash_combine(uint64_t hash, uint64_t value) -> uint64_t
+{
+    return hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+}
+
+/// Lets a std::unordered_map<std::string, ...> be searched with a std::string_view, without allocating a std::string (use it with std::equal_to<>).
+struct StringHash {
+    using is_transparent = void;
+    auto operator()(std::string_view str) const -> size_t { return std::hash<std::string_view>{}(str); }
+};
+
+} // namespace gl::internal
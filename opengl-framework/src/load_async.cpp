@@ -0,0 +1,162 @@
+#include "load_async.hpp"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include "ThreadPool.hpp"
+#include "load_image.hpp"
+#include "make_absolute_path.hpp"
+
+namespace gl {
+
+namespace {
+
+struct PendingUpload {
+    size_t                size_in_bytes{};
+    std::function<void()> upload{};
+};
+
+class AsyncLoader {
+public:
+    void submit(std::function<void()> job) { _thread_pool.submit(std::move(job)); }
+
+    void push_upload(PendingUpload upload)
+    {
+        auto const lock = std::lock_guard{_mutex};
+        _uploads.push_back(std::move(upload));
+    }
+
+    void process_pending_uploads()
+    {
+        auto const start      = std::chrono::steady_clock::now();
+        size_t     bytes_sent = 0;
+        while (true)
+        {
+            auto upload = PendingUpload{};
+            {
+                auto const lock = std::lock_guard{_mutex};
+                if (_uploads.empty())
+                    return;
+                bool const is_first_upload = bytes_sent == 0;
+                if (!is_first_upload && bytes_sent + _uploads.front().size_in_bytes > _budget.max_bytes_per_frame)
+                    return;
+                upload = std::move(_uploads.front());
+                _uploads.pop_front();
+            }
+            upload.upload();
+            bytes_sent += std::max(upload.size_in_bytes, size_t{1});
+            if (std::chrono::duration<float, std::milli>{std::chrono::steady_clock::now() - start}.count() > _budget.max_milliseconds_per_frame)
+                return;
+        }
+    }
+
+    void set_budget(UploadBudget const& budget) { _budget = budget; }
+
+private:
+    std::mutex                _mutex{};
+    std::deque<PendingUpload> _uploads{};
+    UploadBudget              _budget{};
+    // Must be declared last so that the worker threads are stopped before the rest of the members are destroyed
+    internal::ThreadPool _thread_pool{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+};
+
+auto async_loader() -> AsyncLoader&
+{
+    static auto instance = AsyncLoader{};
+    return instance;
+}
+
+auto size_in_bytes(img::Image const& image) -> size_t
+{
+    return image.data_size();
+}
+
+using internal::size_in_bytes;
+
+/// Runs `load` on a worker thread, and then `upload` on the OpenGL thread, with the result of `load`.
+template<typename T, typename LoadFn, typename UploadFn>
+auto load_async(LoadFn&& load, UploadFn&& upload) -> AsyncAsset<T>
+{
+    auto state = std::make_shared<internal::AsyncAssetState<T>>();
+    async_loader().submit([weak_state = std::weak_ptr{state}, load = std::forward<LoadFn>(load), upload = std::forward<UploadFn>(upload)]() {
+        try
+        {
+            // std::function must be copyable, so we store the (potentially move-only) result in a shared_ptr
+            auto result = std::make_shared<decltype(load())>(load());
+            auto size   = size_in_bytes(*result);
+            async_loader().push_upload({
+                .size_in_bytes = size,
+                .upload        = [weak_state, result, upload]() {
+                    if (auto const state = weak_state.lock()) // No need to upload if nobody is waiting for the asset anymore
+                    {
+                        try
+                        {
+                            state->value.emplace(upload(*result));
+                        }
+                        catch (...)
+                        {
+                            state->error = std::current_exception();
+                        }
+                    }
+                },
+            });
+        }
+        catch (...)
+        {
+            // We don't touch the state from the worker thread: only the OpenGL thread reads and writes it
+            async_loader().push_upload({
+                .size_in_bytes = 0,
+                .upload        = [weak_state, error = std::current_exception()]() {
+                    if (auto const state = weak_state.lock())
+                        state->error = error;
+                },
+            });
+        }
+    });
+    return AsyncAsset<T>{std::move(state)};
+}
+
+} // namespace
+
+auto load_texture_async(TextureSource::File const& source, TextureOptions const& options) -> AsyncAsset<Texture>
+{
+    return load_async<Texture>(
+        [source]() { return internal::load_image(make_absolute_path(source.path), source.flip_y); },
+        [source, options](img::Image const& image) {
+            return Texture{
+                TextureSource::Pixels{
+                    .pixels               = image.data_span(),
+                    .width                = static_cast<GLsizei>(image.width()),
+                    .height               = static_cast<GLsizei>(image.height()),
+                    .source_pixels_type   = Type::UnsignedByte,
+                    .source_pixels_format = Format::RGBA,
+                    .texture_format       = source.texture_format,
+                },
+                options,
+            };
+        }
+    );
+}
+
+auto load_mesh_async(std::filesystem::path const& path, LoadObj_Options const& options) -> AsyncAsset<Mesh>
+{
+    return load_async<Mesh>(
+        [path, options]() { return internal::load_obj_cpu_side(path, options); },
+        [](internal::LoadedObj const& obj) { return internal::upload_to_gpu(obj); }
+    );
+}
+
+void set_upload_budget(UploadBudget const& budget)
+{
+    async_loader().set_budget(budget);
+}
+
+namespace internal {
+void process_pending_uploads()
+{
+    async_loader().process_pending_uploads();
+}
+} // namespace internal
+
+} // namespace gl
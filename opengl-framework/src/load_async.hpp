@@ -0,0 +1,29 @@
+#pragma once
+#include <filesystem>
+#include "AsyncAsset.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+#include "load_obj.hpp"
+
+namespace gl {
+
+/// Reads and decodes the image on a worker thread. See AsyncAsset.
+auto load_texture_async(TextureSource::File const&, TextureOptions const& = {}) -> AsyncAsset<Texture>;
+/// Reads and parses the .obj on a worker thread. See AsyncAsset and load_obj().
+auto load_mesh_async(std::filesystem::path const& path, LoadObj_Options const& = {}) -> AsyncAsset<Mesh>;
+
+/// Limits how much work is spent each frame on uploading the assets that have finished loading to the GPU.
+/// At least one asset is uploaded each frame, even if it is bigger than the budget.
+struct UploadBudget {
+    size_t max_bytes_per_frame{32 * 1024 * 1024};
+    float  max_milliseconds_per_frame{2.f};
+};
+
+void set_upload_budget(UploadBudget const&);
+
+namespace internal {
+/// Called once per frame by window_is_open(), on the thread that owns the OpenGL context.
+void process_pending_uploads();
+} // namespace internal
+
+} // namespace gl
@@ -0,0 +1,31 @@
+#include "load_image.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace gl::internal {
+
+static void flip_rows(img::Image& image)
+{
+    auto const row_size = image.width() * static_cast<size_t>(image.channels_count());
+    auto const height   = static_cast<size_t>(image.height());
+    auto const pixels   = image.data_span();
+    for (size_t y = 0; y < height / 2; ++y)
+    {
+        std::swap_ranges(
+            pixels.begin() + static_cast<std::ptrdiff_t>(y * row_size),
+            pixels.begin() + static_cast<std::ptrdiff_t>((y + 1) * row_size),
+            pixels.begin() + static_cast<std::ptrdiff_t>((height - 1 - y) * row_size)
+        );
+    }
+}
+
+auto load_image(std::filesystem::path const& absolute_path, bool flip_y) -> img::Image
+{
+    // We never ask stb_image to flip the image because this setting is a global variable, shared by all the threads that might be loading images at the same time.
+    auto image = img::load(absolute_path, 4, false);
+    if (flip_y)
+        flip_rows(image);
+    return image;
+}
+
+} // namespace gl::internal
@@ -0,0 +1,10 @@
+#pragma once
+#include <filesystem>
+#include "img/img.hpp"
+
+namespace gl::internal {
+
+/// Loads an RGBA image. Safe to call from any thread.
+auto load_image(std::filesystem::path const& absolute_path, bool flip_y) -> img::Image;
+
+} // namespace gl::internal
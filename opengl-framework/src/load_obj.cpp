@@ -0,0 +1,363 @@
+#include "load_obj.hpp"
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include "BinaryMesh.hpp"
+#include "handle_error.hpp"
+#include "hash.hpp"
+#include "MappedFile.hpp"
+#include "make_absolute_path.hpp"
+#include "optimize_mesh.hpp"
+#include "glm/gtc/packing.hpp"
+#include "tiny_obj_loader.h"
+#if defined(_WIN32) && !defined(NOMINMAX)
+#define NOMINMAX // tinyobj_loader_opt.h includes windows.h
+#endif
+#include "tinyobj_loader_opt.h"
+
+namespace gl {
+
+namespace {
+struct ObjIndex {
+    int position{};
+    int uv{};
+    int normal{};
+
+    friend auto operator==(ObjIndex const&, ObjIndex const&) -> bool = default;
+};
+struct ObjIndexHash {
+    auto operator()(ObjIndex const& index) const noexcept -> size_t
+    {
+        uint64_t hash = static_cast<uint64_t>(static_cast<uint32_t>(index.position));
+        hash          = internal::hash_combine(hash, static_cast<uint64_t>(static_cast<uint32_t>(index.uv)));
+        hash          = internal::hash_combine(hash, static_cast<uint64_t>(static_cast<uint32_t>(index.normal)));
+        return static_cast<size_t>(hash);
+    }
+};
+
+/// Copies the `count` floats at position `index` in `values`, or 0s if `is_missing` (meaning that the attribute is missing in the file)
+template<typename Floats>
+void copy_attribute(float* dst, Floats const& values, int index, bool is_missing, size_t count, std::string_view attribute_name)
+{
+    if (is_missing)
+    {
+        std::memset(dst, 0, count * sizeof(float));
+        return;
+    }
+    auto const elements_count = values.size() / count;
+    if (index < 0 || static_cast<size_t>(index) >= elements_count)
+        handle_error(std::format("A face references a {} that doesn't exist (index {}, but there are only {} of them).", attribute_name, index, elements_count));
+    else
+        std::memcpy(dst, &values[count * static_cast<size_t>(index)], count * sizeof(float));
+}
+
+auto pack_normal(glm::vec3 normal) -> uint32_t
+{
+    auto const length = glm::length(normal);
+    if (length > 0.f) // Normals are not always normalized in .obj files, and we can only store values in [-1, 1]
+        normal /= length;
+    return glm::packSnorm3x10_1x2(glm::vec4{normal, 0.f});
+}
+
+auto make_material(tinyobj::material_t const& material, std::filesystem::path const& obj_folder) -> Material
+{
+    return Material{
+        .name            = material.name,
+        .diffuse_color   = glm::vec3{material.diffuse[0], material.diffuse[1], material.diffuse[2]},
+        .diffuse_texture = material.diffuse_texname.empty() ? std::filesystem::path{} : (obj_folder / material.diffuse_texname).lexically_normal(),
+    };
+}
+
+auto layout(LoadObj_Options const& options) -> std::vector<AnyVertexAttribute>
+{
+    if (options.quantize)
+        return {VertexAttribute::Position3D{0}, VertexAttribute::UV_Half{1}, VertexAttribute::Normal3D_Packed{2}};
+    return {VertexAttribute::Position3D{0}, VertexAttribute::UV{1}, VertexAttribute::Normal3D{2}};
+}
+
+/// Works both with the attributes of tinyobj and of tinyobj_opt
+template<typename Attrib>
+class MeshDataBuilder {
+public:
+    MeshDataBuilder(Attrib const& attrib, size_t indices_count, LoadObj_Options const& options)
+        : _attrib{attrib}
+        , _quantize{options.quantize}
+        , _data{.layout = gl::layout(options)}
+        , _stride{_data.vertex_stride()}
+    {
+        // There are at least as many unique vertices as there are positions, and usually not much more
+        auto const expected_vertices_count = std::min(indices_count, attrib.vertices.size() / 3);
+        _data.indices.reserve(indices_count);
+        _data.vertices.reserve(expected_vertices_count * _stride);
+        _unique_vertices.reserve(expected_vertices_count);
+    }
+
+    template<typename Index>
+    void add(Index const& idx)
+    {
+        auto const [it, is_new_vertex] = _unique_vertices.try_emplace(
+            ObjIndex{.position = idx.vertex_index, .uv = idx.texcoord_index, .normal = idx.normal_index},
+            static_cast<uint32_t>(_unique_vertices.size())
+        );
+        if (is_new_vertex)
+        {
+            auto const offset = _data.vertices.size();
+            _data.vertices.resize(offset + _stride);
+            write_vertex(&_data.vertices[offset], idx);
+        }
+        _data.indices.push_back(it->second);
+    }
+
+    /// All the indices that have been added since the previous submesh will belong to this new submesh.
+    void add_submesh(Material material)
+    {
+        auto const first_index = _data.submeshes.empty() ? 0 : _data.submeshes.back().range.first_index + _data.submeshes.back().range.indices_count;
+        _data.submeshes.push_back(Submesh{
+            .range    = {.first_index = first_index, .indices_count = static_cast<uint32_t>(_data.indices.size()) - first_index},
+            .material = std::move(material),
+        });
+    }
+
+    auto build() && -> MeshData { return std::move(_data); }
+
+private:
+    /// True if the face doesn't specify this attribute (e.g. `f 1//1` has no texture coordinate).
+    static auto is_missing(int index, size_t elements_count) -> bool
+    {
+        if constexpr (std::is_same_v<Attrib, tinyobj_opt::attrib_t>)
+        {
+            // tinyobj_opt marks a missing index with INT_MIN, and then treats it as a relative index and adds the number of elements parsed so far (see fixIndex()), so it ends up in [INT_MIN, INT_MIN + elements_count].
+            // It doesn't check the other indices, so anything else that is out of range is an error in the file.
+            return static_cast<int64_t>(index) - std::numeric_limits<int>::min() <= static_cast<int64_t>(elements_count);
+        }
+        else
+        {
+            return index == -1; // tinyobj has already checked that the other indices are in range
+        }
+    }
+
+    template<typename Index>
+    void write_vertex(std::byte* dst, Index const& idx) const
+    {
+        auto position = std::array<float, 3>{};
+        auto uv       = std::array<float, 2>{};
+        auto normal   = std::array<float, 3>{};
+        copy_attribute(position.data(), _attrib.vertices, idx.vertex_index, is_missing(idx.vertex_index, _attrib.vertices.size() / 3), 3, "position");
+        copy_attribute(uv.data(), _attrib.texcoords, idx.texcoord_index, is_missing(idx.texcoord_index, _attrib.texcoords.size() / 2), 2, "texture coordinate");
+        copy_attribute(normal.data(), _attrib.normals, idx.normal_index, is_missing(idx.normal_index, _attrib.normals.size() / 3), 3, "normal");
+
+        std::memcpy(dst, position.data(), sizeof(position));
+        dst += sizeof(position);
+        if (!_quantize)
+        {
+            std::memcpy(dst, uv.data(), sizeof(uv));
+            std::memcpy(dst + sizeof(uv), normal.data(), sizeof(normal));
+        }
+        else
+        {
+            auto const packed_uv     = glm::packHalf2x16(glm::vec2{uv[0], uv[1]});
+            auto const packed_normal = pack_normal(glm::vec3{normal[0], normal[1], normal[2]});
+            std::memcpy(dst, &packed_uv, sizeof(packed_uv));
+            std::memcpy(dst + sizeof(packed_uv), &packed_normal, sizeof(packed_normal));
+        }
+    }
+
+private:
+    Attrib const&                                        _attrib; // NOLINT(*avoid-const-or-ref-data-members)
+    bool                                                 _quantize;
+    MeshData                                             _data;
+    size_t                                               _stride;
+    std::unordered_map<ObjIndex, uint32_t, ObjIndexHash> _unique_vertices{};
+};
+
+/// Remembers the .mtl files that the .obj uses, so that the binary cache can detect when they change.
+class RecordingMaterialReader : public tinyobj::MaterialFileReader {
+public:
+    explicit RecordingMaterialReader(std::filesystem::path const& obj_folder)
+        : tinyobj::MaterialFileReader{obj_folder.string()}
+    {}
+
+    auto operator()(std::string const& material_file, std::vector<tinyobj::material_t>* materials, std::map<std::string, int>* materials_map, std::string* warning, std::string* error) -> bool override
+    {
+        _material_files.emplace_back(material_file);
+        return tinyobj::MaterialFileReader::operator()(material_file, materials, materials_map, warning, error);
+    }
+
+    auto material_files() && -> std::vector<std::filesystem::path> { return std::move(_material_files); }
+
+private:
+    std::vector<std::filesystem::path> _material_files{}; // Relative to the folder of the .obj
+};
+
+struct ParsedObj {
+    MeshData                           data{};
+    std::vector<std::filesystem::path> material_files{}; // Relative to the folder of the .obj
+};
+
+auto load_obj_data_singlethreaded(std::filesystem::path const& absolute_path, LoadObj_Options const& options) -> ParsedObj
+{
+    auto attrib          = tinyobj::attrib_t{};
+    auto shapes          = std::vector<tinyobj::shape_t>{};
+    auto materials       = std::vector<tinyobj::material_t>{};
+    auto warning         = std::string{};
+    auto error           = std::string{};
+    auto ifs             = std::ifstream{absolute_path};
+    auto material_reader = RecordingMaterialReader{absolute_path.parent_path()};
+    if (!ifs || !tinyobj::LoadObj(&attrib, &shapes, &materials, &warning, &error, &ifs, &material_reader, /*triangulate=*/true, /*default_vcols_fallback=*/false))
+        handle_error(std::format("Failed to load \"{}\":\n{}", absolute_path.string(), error));
+
+    size_t indices_count = 0;
+    for (auto const& shape : shapes)
+        indices_count += shape.mesh.indices.size();
+
+    // Group the faces by material, so that each material is a contiguous range of the index buffer
+    struct Face {
+        size_t shape{};
+        size_t first_index{};
+    };
+    auto faces_per_material = std::vector<std::vector<Face>>(materials.size() + 1); // The first group is for the faces that don't have a material
+    for (size_t shape = 0; shape < shapes.size(); ++shape)
+    {
+        auto const& mesh = shapes[shape].mesh;
+        for (size_t face = 0; face < mesh.material_ids.size(); ++face) // All the faces have been triangulated
+        {
+            auto const material_id = mesh.material_ids[face];
+            auto const group       = material_id >= 0 && static_cast<size_t>(material_id) < materials.size() ? static_cast<size_t>(material_id) + 1 : 0;
+            faces_per_material[group].push_back({.shape = shape, .first_index = face * 3});
+        }
+    }
+
+    auto builder = MeshDataBuilder{attrib, indices_count, options};
+    for (size_t group = 0; group < faces_per_material.size(); ++group)
+    {
+        if (faces_per_material[group].empty())
+            continue;
+        for (auto const& face : faces_per_material[group])
+        {
+            for (size_t k = 0; k < 3; ++k)
+                builder.add(shapes[face.shape].mesh.indices[face.first_index + k]);
+        }
+        builder.add_submesh(group == 0 ? Material{} : make_material(materials[group - 1], absolute_path.parent_path()));
+    }
+    return ParsedObj{
+        .data           = std::move(builder).build(),
+        .material_files = std::move(material_reader).material_files(),
+    };
+}
+
+auto load_obj_data_multithreaded(std::filesystem::path const& absolute_path, LoadObj_Options const& options) -> ParsedObj
+{
+    auto const file      = internal::MappedFile{absolute_path};
+    auto       attrib    = tinyobj_opt::attrib_t{};
+    auto       shapes    = std::vector<tinyobj_opt::shape_t>{};
+    auto       materials = std::vector<tinyobj_opt::material_t>{};
+    auto const load_opts = tinyobj_opt::LoadOption{}; // Uses all the hardware threads by default
+    auto const bytes     = file.bytes();
+    if (!tinyobj_opt::parseObj(&attrib, &shapes, &materials, reinterpret_cast<char const*>(bytes.data()), bytes.size(), load_opts)) // NOLINT(*reinterpret-cast)
+        handle_error(std::format("Failed to load \"{}\".", absolute_path.string()));
+
+    // All the faces have been triangulated, so the indices are already a list of triangles
+    auto builder = MeshDataBuilder{attrib, attrib.indices.size(), options};
+    for (auto const& idx : attrib.indices)
+        builder.add(idx);
+    builder.add_submesh({}); // The .mtl files are ignored in this mode
+    return ParsedObj{.data = std::move(builder).build()};
+}
+
+auto binary_cache_path(std::filesystem::path const& absolute_path) -> std::filesystem::path
+{
+    auto path = absolute_path;
+    path += ".glmesh";
+    return path;
+}
+
+/// Only takes into account the options that have an impact on the generated data
+auto options_hash(LoadObj_Options const& options) -> uint64_t
+{
+    return (options.quantize ? 1u : 0u)
+           | (options.optimize ? 2u : 0u)
+           | (options.multithreaded ? 4u : 0u); // The multithreaded parser ignores the .mtl files, so it doesn't generate the same submeshes
+}
+
+auto parse_obj(std::filesystem::path const& absolute_path, LoadObj_Options const& options) -> MeshData
+{
+    auto obj = options.multithreaded
+                   ? load_obj_data_multithreaded(absolute_path, options)
+                   : load_obj_data_singlethreaded(absolute_path, options);
+    if (options.optimize)
+        optimize_mesh(obj.data);
+
+    if (options.binary_cache)
+    {
+        auto const cache_path = binary_cache_path(absolute_path);
+        if (!internal::BinaryMesh::write(cache_path, obj.data, internal::binary_mesh_source(absolute_path, obj.material_files, options_hash(options))))
+            std::cerr << std::format("[opengl_framework] Failed to write the binary cache \"{}\".\n", cache_path.string());
+    }
+    return std::move(obj.data);
+}
+
+auto open_binary_cache(std::filesystem::path const& absolute_path, LoadObj_Options const& options) -> std::optional<internal::BinaryMesh>
+{
+    if (!options.binary_cache)
+        return std::nullopt;
+    return internal::BinaryMesh::open(binary_cache_path(absolute_path), absolute_path, options_hash(options));
+}
+
+} // namespace
+
+auto load_obj_data(std::filesystem::path const& path, LoadObj_Options const& options) -> MeshData
+{
+    auto const absolute_path = make_absolute_path(path);
+    if (auto const cache = open_binary_cache(absolute_path, options))
+        return cache->to_mesh_data();
+    return parse_obj(absolute_path, options);
+}
+
+auto load_obj(std::filesystem::path const& path, LoadObj_Options const& options) -> Mesh
+{
+    return internal::upload_to_gpu(internal::load_obj_cpu_side(path, options));
+}
+
+namespace internal {
+
+auto load_obj_cpu_side(std::filesystem::path const& path, LoadObj_Options const& options) -> LoadedObj
+{
+    auto const absolute_path = make_absolute_path(path);
+    if (auto cache = open_binary_cache(absolute_path, options))
+        return std::move(*cache);
+    return parse_obj(absolute_path, options);
+}
+
+auto upload_to_gpu(LoadedObj const& obj) -> Mesh
+{
+    if (auto const* cache = std::get_if<BinaryMesh>(&obj))
+        return cache->to_mesh(); // Sends the memory-mapped file straight to the GPU, without any intermediate copy
+
+    auto const& data = std::get<MeshData>(obj);
+    return Mesh{MeshBytes_Descriptor{
+        .layout       = data.layout,
+        .vertex_data  = data.vertices,
+        .index_buffer = data.indices,
+        .submeshes    = data.submeshes,
+    }};
+}
+
+auto size_in_bytes(LoadedObj const& obj) -> size_t
+{
+    if (auto const* cache = std::get_if<BinaryMesh>(&obj))
+        return cache->vertex_data().size_bytes() + cache->indices().size_bytes();
+
+    auto const& data = std::get<MeshData>(obj);
+    return data.vertices.size() + data.indices.size() * sizeof(uint32_t);
+}
+
+} // namespace internal
+
+} // namespace gl
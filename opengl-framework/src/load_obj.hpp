@@ -0,0 +1,44 @@
+#pragma once
+#include <filesystem>
+#include <variant>
+#include "BinaryMesh.hpp"
+#include "Mesh.hpp"
+#include "MeshData.hpp"
+
+namespace gl {
+
+struct LoadObj_Options {
+    /// Memory-maps the file and parses it on all the cores of your CPU. Only worth it for big files (several MB).
+    /// NB: .mtl files are ignored in this mode.
+    bool multithreaded{false};
+    /// The first time a file is loaded, a binary version of the mesh is written next to it (e.g. "my_mesh.obj.glmesh").
+    /// All subsequent loads map that file in memory and send it straight to the GPU, which is way faster than parsing the .obj.
+    /// The binary file is automatically regenerated when the .obj (or one of its .mtl files) changes.
+    bool binary_cache{true};
+    /// Stores the UVs as half floats and the normals as 10-bit normalized integers.
+    /// This makes each vertex 20 bytes instead of 32, with no visible loss of quality.
+    /// The layout becomes {Position3D{0}, UV_Half{1}, Normal3D_Packed{2}}, which doesn't require any change to your shaders.
+    bool quantize{false};
+    /// Reorders the triangles and the vertices for faster rendering (see optimize_mesh()).
+    /// It takes some time on big meshes, but with the binary cache this is only paid the first time the file is loaded.
+    bool optimize{true};
+};
+
+/// Loads an .obj file. Vertices that are shared between several faces are only stored once, and referenced through the index buffer.
+/// The layout is {Position3D{0}, UV{1}, Normal3D{2}} (unless you use LoadObj_Options::quantize). If the file has no UVs or no normals, they are set to 0.
+auto load_obj_data(std::filesystem::path const& path, LoadObj_Options const& = {}) -> MeshData;
+/// Loads an .obj file and directly uploads it to the GPU. See load_obj_data() for more details.
+auto load_obj(std::filesystem::path const& path, LoadObj_Options const& = {}) -> Mesh;
+
+namespace internal {
+/// Either the memory-mapped binary cache, or the freshly parsed .obj
+using LoadedObj = std::variant<BinaryMesh, MeshData>;
+/// Does all the work of load_obj() that doesn't require OpenGL, so it can be run on any thread.
+auto load_obj_cpu_side(std::filesystem::path const& path, LoadObj_Options const&) -> LoadedObj;
+/// Must be called on the thread that owns the OpenGL context.
+auto upload_to_gpu(LoadedObj const&) -> Mesh;
+/// How much data upload_to_gpu() is going to send to the GPU.
+auto size_in_bytes(LoadedObj const&) -> size_t;
+} // namespace internal
+
+} // namespace gl
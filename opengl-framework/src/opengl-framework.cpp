@@ -7,9 +7,13 @@
 #include "Camera.hpp"
 #include "GLFW/glfw3.h"
 #include "Shader.hpp"
+#include "StateCache.hpp"
+#include "UniformBuffer.hpp"
+#include "gl_extensions.hpp"
 #include "glfw.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "handle_error.hpp"
+#include "load_async.hpp"
 
 namespace {
 struct Context { // NOLINT(*special-member-functions)
@@ -170,6 +174,7 @@ void init(std::string_view window_title)
     glfwMakeContextCurrent(context().window);
     if (!gladLoadGL(glfwGetProcAddress))
         handle_error("[opengl_framework] Failed to initialize glad");
+    internal::load_gl_extensions(glfwGetProcAddress);
 
 #if !defined(NDEBUG) && !defined(__APPLE__)
     int flags; // NOLINT(*init-variables)
@@ -213,8 +218,12 @@ auto window_is_open() -> bool
         context().delta_time = time - context().last_time;
     context().last_time = time;
 
+    internal::uniform_buffers_next_frame();
+    internal::state_cache_next_frame();
     glfwSwapBuffers(context().window);
     glfwPollEvents();
+    internal::process_pending_uploads();
+    internal::process_pending_shader_compilations();
     context().is_first_frame = false;
     return !glfwWindowShouldClose(context().window);
 }
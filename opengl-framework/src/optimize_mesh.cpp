@@ -0,0 +1,346 @@
+#include "optimize_mesh.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+namespace gl {
+
+namespace {
+
+constexpr auto no_vertex   = std::numeric_limits<uint32_t>::max();
+constexpr auto no_triangle = std::numeric_limits<size_t>::max();
+
+auto count_misses(std::span<uint32_t const> indices, std::vector<uint32_t>& timestamps, uint32_t& time, size_t cache_size) -> size_t
+{
+    size_t misses = 0;
+    for (auto const index : indices)
+    {
+        if (time - timestamps[index] > cache_size) // A FIFO cache only cares about the time at which the vertex entered the cache, not about when it was last used
+        {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+/// Simulated cache size used by Forsyth's algorithm. It is bigger than the real caches on purpose, which gives better results on all GPUs.
+constexpr size_t forsyth_cache_size = 32;
+
+/// See https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+auto forsyth_vertex_score(int cache_position, uint32_t remaining_triangles) -> float
+{
+    if (remaining_triangles == 0)
+        return -1.f;
+
+    auto score = 0.f;
+    if (cache_position >= 0)
+    {
+        if (cache_position < 3) // The vertices of the triangle we just emitted get a fixed score, otherwise we would favor strips too much
+            score = 0.75f;
+        else
+            score = std::pow(1.f - static_cast<float>(cache_position - 3) / static_cast<float>(forsyth_cache_size - 3), 1.5f);
+    }
+    score += 2.f / std::sqrt(static_cast<float>(remaining_triangles)); // Favors the vertices that only have a few triangles left, so that we don't leave lonely triangles behind that would need to be picked up later
+    return score;
+}
+
+/// Index of the first triangle of each group of triangles that can be moved around freely without hurting the vertex cache too much.
+auto overdraw_clusters(std::span<uint32_t const> indices, size_t vertices_count, float threshold) -> std::vector<size_t>
+{
+    static constexpr size_t cache_size          = 16;
+    static constexpr size_t min_triangles_count = 8;
+
+    auto const triangles_count = indices.size() / 3;
+
+    // Hard boundaries: triangles that had a miss on all their vertices. The cache is empty of anything useful there, so starting a new cluster doesn't cost anything.
+    auto hard_boundaries = std::vector<size_t>{};
+    auto misses          = std::vector<size_t>(triangles_count);
+    {
+        auto timestamps = std::vector<uint32_t>(vertices_count, 0);
+        auto time       = static_cast<uint32_t>(cache_size + 1);
+        for (size_t triangle = 0; triangle < triangles_count; ++triangle)
+        {
+            misses[triangle] = count_misses(indices.subspan(triangle * 3, 3), timestamps, time, cache_size);
+            if (misses[triangle] == 3)
+                hard_boundaries.push_back(triangle);
+        }
+    }
+    if (hard_boundaries.empty() || hard_boundaries.front() != 0)
+        hard_boundaries.insert(hard_boundaries.begin(), 0);
+    hard_boundaries.push_back(triangles_count);
+
+    // Soft boundaries: we also split each hard cluster as soon as the triangles seen so far have an ACMR that is not much worse than the whole cluster.
+    auto clusters = std::vector<size_t>{};
+    for (size_t i = 0; i + 1 < hard_boundaries.size(); ++i)
+    {
+        auto const begin          = hard_boundaries[i];
+        auto const end            = hard_boundaries[i + 1];
+        auto const cluster_misses = std::accumulate(misses.begin() + static_cast<std::ptrdiff_t>(begin), misses.begin() + static_cast<std::ptrdiff_t>(end), size_t{0});
+        auto const cluster_acmr   = static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+        clusters.push_back(begin);
+        size_t start          = begin;
+        size_t running_misses = 0;
+        for (size_t triangle = begin; triangle < end; ++triangle)
+        {
+            running_misses += misses[triangle];
+            auto const running_count = triangle + 1 - start;
+            if (running_count >= min_triangles_count
+                && triangle + 1 < end
+                && static_cast<float>(running_misses) / static_cast<float>(running_count) <= cluster_acmr * threshold)
+            {
+                clusters.push_back(triangle + 1);
+                start          = triangle + 1;
+                running_misses = 0;
+            }
+        }
+    }
+    return clusters;
+}
+
+/// Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw".
+/// Clusters that face outwards are drawn first, because they are the most likely to occlude the rest of the mesh.
+auto reduce_overdraw(MeshData const& data, std::span<uint32_t const> indices, float threshold) -> std::vector<uint32_t>
+{
+    auto const clusters = overdraw_clusters(indices, data.vertices_count(), threshold);
+
+    auto mesh_centroid = glm::vec3{0.f};
+    auto mesh_area     = 0.f;
+
+    struct Cluster {
+        size_t    begin{};
+        size_t    end{};
+        glm::vec3 centroid{0.f}; // Weighted by the area of each triangle
+        glm::vec3 normal{0.f};   // Sum of the normals of all the triangles, weighted by their area
+        float     area{};
+        float     sort_key{};
+    };
+    auto infos = std::vector<Cluster>(clusters.size());
+    for (size_t i = 0; i < clusters.size(); ++i)
+    {
+        auto& cluster = infos[i];
+        cluster.begin = clusters[i];
+        cluster.end   = i + 1 < clusters.size() ? clusters[i + 1] : indices.size() / 3;
+        for (size_t triangle = cluster.begin; triangle < cluster.end; ++triangle)
+        {
+            auto const p0    = data.position(indices[triangle * 3 + 0]);
+            auto const p1    = data.position(indices[triangle * 3 + 1]);
+            auto const p2    = data.position(indices[triangle * 3 + 2]);
+            auto const cross = glm::cross(p1 - p0, p2 - p0); // Its length is twice the area of the triangle
+            auto const area  = glm::length(cross);
+            cluster.centroid += (p0 + p1 + p2) / 3.f * area;
+            cluster.normal += cross;
+            cluster.area += area;
+        }
+        mesh_centroid += cluster.centroid;
+        mesh_area += cluster.area;
+        if (cluster.area > 0.f)
+            cluster.centroid /= cluster.area;
+    }
+    if (mesh_area > 0.f)
+        mesh_centroid /= mesh_area;
+
+    for (auto& cluster : infos)
+    {
+        auto const normal_length = glm::length(cluster.normal);
+        cluster.sort_key         = normal_length > 0.f
+                                       ? glm::dot(cluster.centroid - mesh_centroid, cluster.normal / normal_length)
+                                       : std::numeric_limits<float>::lowest();
+    }
+    std::stable_sort(infos.begin(), infos.end(), [](Cluster const& a, Cluster const& b) {
+        return a.sort_key > b.sort_key;
+    });
+
+    auto result = std::vector<uint32_t>{};
+    result.reserve(indices.size());
+    for (auto const& cluster : infos)
+        result.insert(result.end(), indices.begin() + static_cast<std::ptrdiff_t>(cluster.begin * 3), indices.begin() + static_cast<std::ptrdiff_t>(cluster.end * 3));
+    return result;
+}
+
+/// Reorders the vertices in the order they are first referenced by the index buffer, and removes the ones that are never used.
+void optimize_vertex_fetch(MeshData& data)
+{
+    auto const stride   = data.vertex_stride();
+    auto       remap    = std::vector<uint32_t>(data.vertices_count(), no_vertex);
+    auto       vertices = std::vector<std::byte>{};
+    vertices.reserve(data.vertices.size());
+
+    uint32_t vertices_count = 0;
+    for (auto& index : data.indices)
+    {
+        if (remap[index] == no_vertex)
+        {
+            remap[index] = vertices_count++;
+            vertices.insert(vertices.end(), data.vertices.begin() + static_cast<std::ptrdiff_t>(index * stride), data.vertices.begin() + static_cast<std::ptrdiff_t>((index + 1) * stride));
+        }
+        index = remap[index];
+    }
+    data.vertices = std::move(vertices);
+}
+
+} // namespace
+
+auto vertex_cache_stats(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size) -> VertexCache_Stats
+{
+    if (indices.empty())
+        return {};
+
+    auto       timestamps = std::vector<uint32_t>(vertices_count, 0);
+    auto       time       = static_cast<uint32_t>(cache_size + 1);
+    auto const misses     = count_misses(indices, timestamps, time, cache_size);
+
+    auto is_used = std::vector<bool>(vertices_count, false);
+    for (auto const index : indices)
+        is_used[index] = true;
+    auto const used_vertices_count = std::count(is_used.begin(), is_used.end(), true);
+
+    return VertexCache_Stats{
+        .acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3),
+        .atvr = static_cast<float>(misses) / static_cast<float>(used_vertices_count),
+    };
+}
+
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertices_count)
+{
+    assert(indices.size() % 3 == 0);
+    auto const triangles_count = indices.size() / 3;
+    if (triangles_count == 0)
+        return;
+
+    // For each vertex, the list of triangles that use it and haven't been emitted yet (the first `remaining_triangles[vertex]` entries starting at `adjacency_offsets[vertex]`)
+    auto remaining_triangles = std::vector<uint32_t>(vertices_count, 0);
+    for (auto const index : indices)
+        remaining_triangles[index]++;
+    auto adjacency_offsets = std::vector<uint32_t>(vertices_count + 1, 0);
+    for (size_t vertex = 0; vertex < vertices_count; ++vertex)
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + remaining_triangles[vertex];
+    auto adjacency = std::vector<uint32_t>(indices.size());
+    {
+        auto fill = adjacency_offsets;
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    auto cache_position = std::vector<int>(vertices_count, -1);
+    auto vertex_score   = std::vector<float>(vertices_count);
+    for (size_t vertex = 0; vertex < vertices_count; ++vertex)
+        vertex_score[vertex] = forsyth_vertex_score(-1, remaining_triangles[vertex]);
+
+    auto triangle_score = std::vector<float>(triangles_count);
+    auto is_emitted     = std::vector<bool>(triangles_count, false);
+    for (size_t triangle = 0; triangle < triangles_count; ++triangle)
+        triangle_score[triangle] = vertex_score[indices[triangle * 3 + 0]] + vertex_score[indices[triangle * 3 + 1]] + vertex_score[indices[triangle * 3 + 2]];
+
+    auto result = std::vector<uint32_t>{};
+    result.reserve(indices.size());
+    auto cache     = std::vector<uint32_t>{};
+    auto new_cache = std::vector<uint32_t>{};
+    cache.reserve(forsyth_cache_size + 3);
+    new_cache.reserve(forsyth_cache_size + 3);
+
+    auto   best_triangle         = static_cast<size_t>(std::max_element(triangle_score.begin(), triangle_score.end()) - triangle_score.begin());
+    size_t first_maybe_remaining = 0;
+    while (result.size() < indices.size())
+    {
+        if (best_triangle == no_triangle) // None of the vertices in the cache has any triangle left, so we just pick any triangle that hasn't been emitted yet
+        {
+            while (is_emitted[first_maybe_remaining])
+                first_maybe_remaining++;
+            best_triangle = first_maybe_remaining;
+        }
+
+        // Emit the triangle
+        is_emitted[best_triangle] = true;
+        new_cache.clear();
+        for (size_t k = 0; k < 3; ++k)
+        {
+            auto const vertex = indices[best_triangle * 3 + k];
+            result.push_back(vertex);
+
+            auto const begin = adjacency.begin() + adjacency_offsets[vertex];
+            auto const end   = begin + remaining_triangles[vertex];
+            std::iter_swap(std::find(begin, end, static_cast<uint32_t>(best_triangle)), end - 1);
+            remaining_triangles[vertex]--;
+
+            if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+                new_cache.push_back(vertex);
+        }
+
+        // Update the cache, with the vertices of the triangle moving to the front
+        for (auto const vertex : cache)
+        {
+            if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+                new_cache.push_back(vertex);
+        }
+        for (size_t i = 0; i < new_cache.size(); ++i)
+        {
+            auto const vertex      = new_cache[i];
+            cache_position[vertex] = i < forsyth_cache_size ? static_cast<int>(i) : -1;
+
+            auto const new_score = forsyth_vertex_score(cache_position[vertex], remaining_triangles[vertex]);
+            auto const delta     = new_score - vertex_score[vertex];
+            vertex_score[vertex] = new_score;
+            for (uint32_t j = 0; j < remaining_triangles[vertex]; ++j)
+                triangle_score[adjacency[adjacency_offsets[vertex] + j]] += delta;
+        }
+        new_cache.resize(std::min(new_cache.size(), forsyth_cache_size));
+        std::swap(cache, new_cache);
+
+        // The next triangle is the best one among those that use a vertex in the cache
+        best_triangle   = no_triangle;
+        auto best_score = 0.f;
+        for (auto const vertex : cache)
+        {
+            for (uint32_t j = 0; j < remaining_triangles[vertex]; ++j)
+            {
+                auto const triangle = adjacency[adjacency_offsets[vertex] + j];
+                if (triangle_score[triangle] > best_score)
+                {
+                    best_score    = triangle_score[triangle];
+                    best_triangle = triangle;
+                }
+            }
+        }
+    }
+    std::copy(result.begin(), result.end(), indices.begin());
+}
+
+auto optimize_mesh(MeshData& data, OptimizeMesh_Options const& options) -> OptimizeMesh_Stats
+{
+    auto stats   = OptimizeMesh_Stats{};
+    stats.before = vertex_cache_stats(data.indices, data.vertices_count());
+
+    // Each submesh is optimized on its own, so that the triangles stay in their submesh's range
+    auto ranges = std::vector<IndexRange>{};
+    for (auto const& submesh : data.submeshes)
+        ranges.push_back(submesh.range);
+    if (ranges.empty())
+        ranges.push_back({.first_index = 0, .indices_count = static_cast<uint32_t>(data.indices.size())});
+
+    bool const has_positions = !data.layout.empty() && std::holds_alternative<VertexAttribute::Position3D>(data.layout[0]);
+    for (auto const& range : ranges)
+    {
+        auto const indices = std::span{data.indices}.subspan(range.first_index, range.indices_count);
+        optimize_vertex_cache(indices, data.vertices_count());
+
+        if (options.reduce_overdraw && has_positions)
+        {
+            auto const reordered  = reduce_overdraw(data, indices, options.overdraw_threshold);
+            auto const acmr_cache = vertex_cache_stats(indices, data.vertices_count()).acmr;
+            if (vertex_cache_stats(reordered, data.vertices_count()).acmr <= acmr_cache * options.overdraw_threshold) // The clusters are only an estimation, so we make sure we didn't lose too much on the vertex cache side
+                std::copy(reordered.begin(), reordered.end(), indices.begin());
+        }
+    }
+
+    optimize_vertex_fetch(data);
+
+    stats.after = vertex_cache_stats(data.indices, data.vertices_count());
+    return stats;
+}
+
+} // namespace gl
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "MeshData.hpp"
+
+namespace gl {
+
+struct VertexCache_Stats {
+    /// Average Cache Miss Ratio: number of vertex shader invocations per triangle. Between 0.5 (ideal, for big regular grids) and 3 (no reuse at all).
+    float acmr{};
+    /// Average Transformed Vertex Ratio: number of vertex shader invocations per vertex. 1 is ideal: each vertex is only processed once.
+    float atvr{};
+};
+
+/// Simulates a FIFO post-transform vertex cache (which is a good model of most GPUs) to measure how well an index buffer makes use of it.
+auto vertex_cache_stats(std::span<uint32_t const> indices, size_t vertices_count, size_t cache_size = 16) -> VertexCache_Stats;
+
+struct OptimizeMesh_Options {
+    /// Reorders the triangles so that the ones that face outwards are drawn first, which reduces overdraw.
+    /// Requires the first attribute of the layout to be a Position3D.
+    bool reduce_overdraw{true};
+    /// How much worse the ACMR is allowed to get when reordering for overdraw. 1.05 means 5% worse.
+    float overdraw_threshold{1.05f};
+};
+
+struct OptimizeMesh_Stats {
+    VertexCache_Stats before{};
+    VertexCache_Stats after{};
+};
+
+/// Reorders the triangles and the vertices of the mesh so that it renders faster, without changing what it looks like:
+///  - triangles are reordered to make the best use of the post-transform vertex cache (Forsyth's algorithm),
+///  - then, if enabled, groups of triangles are reordered to reduce overdraw,
+///  - then vertices are reordered in the order they are first used by the index buffer, so that they are fetched linearly from memory.
+/// Vertices that aren't referenced by any triangle are removed. Triangles never move from one submesh to another.
+/// This is done automatically by load_obj(), unless you disable LoadObj_Options::optimize.
+auto optimize_mesh(MeshData&, OptimizeMesh_Options const& = {}) -> OptimizeMesh_Stats;
+
+/// Only reorders the triangles, for better use of the post-transform vertex cache. Works with any kind of vertex buffer.
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertices_count);
+
+} // namespace gl
@@ -0,0 +1,270 @@
+#include "simplify_mesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include "hash.hpp"
+
+namespace gl {
+
+namespace {
+
+/// Sum of the squared distances to a set of planes, stored as a symmetric 4x4 matrix.
+/// Each plane is weighted by the area of its triangle, so that we can compute an average distance.
+struct Quadric {
+    std::array<double, 10> m{}; // a00, a01, a02, a03, a11, a12, a13, a22, a23, a33
+    double                 weight{};
+
+    static auto from_plane(glm::dvec3 const& normal, double d, double weight) -> Quadric
+    {
+        auto const [a, b, c] = std::array{normal.x, normal.y, normal.z};
+        return Quadric{
+            .m      = {weight * a * a, weight * a * b, weight * a * c, weight * a * d, weight * b * b, weight * b * c, weight * b * d, weight * c * c, weight * c * d, weight * d * d},
+            .weight = weight,
+        };
+    }
+
+    auto operator+=(Quadric const& o) -> Quadric&
+    {
+        for (size_t i = 0; i < m.size(); ++i)
+            m[i] += o.m[i];
+        weight += o.weight;
+        return *this;
+    }
+
+    /// Average squared distance between `p` and the planes
+    auto error(glm::dvec3 const& p) const -> double
+    {
+        if (weight <= 0.)
+            return 0.;
+        auto const sum = m[0] * p.x * p.x + 2. * m[1] * p.x * p.y + 2. * m[2] * p.x * p.z + 2. * m[3] * p.x
+                         + m[4] * p.y * p.y + 2. * m[5] * p.y * p.z + 2. * m[6] * p.y
+                         + m[7] * p.z * p.z + 2. * m[8] * p.z
+                         + m[9];
+        return std::max(sum, 0.) / weight; // The sum can be slightly negative because of floating point errors
+    }
+};
+
+struct Vec3Hash {
+    auto operator()(glm::vec3 const& v) const noexcept -> size_t
+    {
+        return static_cast<size_t>(internal::hash_bytes(std::as_bytes(std::span{&v, 1})));
+    }
+};
+
+/// Vertices that must not be moved, otherwise a hole would appear in the mesh:
+///  - the ones that share their position with another vertex (seams between UV islands, hard edges, etc.),
+///  - the ones that are on the border of the mesh, or on a non-manifold edge.
+auto find_locked_vertices(std::vector<glm::vec3> const& positions, std::span<uint32_t const> indices) -> std::vector<bool>
+{
+    auto is_locked = std::vector<bool>(positions.size(), false);
+
+    auto welded = std::vector<uint32_t>(positions.size());
+    {
+        auto first_vertex_at = std::unordered_map<glm::vec3, uint32_t, Vec3Hash>{};
+        first_vertex_at.reserve(positions.size());
+        for (uint32_t vertex = 0; vertex < positions.size(); ++vertex)
+        {
+            auto const [it, is_new] = first_vertex_at.try_emplace(positions[vertex], vertex);
+            welded[vertex]          = it->second;
+            if (!is_new)
+            {
+                is_locked[vertex]     = true;
+                is_locked[it->second] = true;
+            }
+        }
+    }
+
+    auto edges_count = std::unordered_map<uint64_t, uint32_t>{};
+    edges_count.reserve(indices.size());
+    auto const edge_key = [&](uint32_t a, uint32_t b) {
+        a = welded[a];
+        b = welded[b];
+        return (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+    };
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (size_t k = 0; k < 3; ++k)
+            edges_count[edge_key(indices[i + k], indices[i + (k + 1) % 3])]++;
+    }
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (size_t k = 0; k < 3; ++k)
+        {
+            auto const a = indices[i + k];
+            auto const b = indices[i + (k + 1) % 3];
+            if (edges_count[edge_key(a, b)] != 2)
+            {
+                is_locked[a] = true;
+                is_locked[b] = true;
+            }
+        }
+    }
+    return is_locked;
+}
+
+auto compute_quadrics(std::vector<glm::vec3> const& positions, std::span<uint32_t const> indices) -> std::vector<Quadric>
+{
+    auto quadrics = std::vector<Quadric>(positions.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        auto const p0     = glm::dvec3{positions[indices[i + 0]]};
+        auto const p1     = glm::dvec3{positions[indices[i + 1]]};
+        auto const p2     = glm::dvec3{positions[indices[i + 2]]};
+        auto const cross  = glm::cross(p1 - p0, p2 - p0);
+        auto const length = glm::length(cross);
+        if (length <= 0.)
+            continue;
+        auto const normal  = cross / length;
+        auto const quadric = Quadric::from_plane(normal, -glm::dot(normal, p0), length / 2.);
+        for (size_t k = 0; k < 3; ++k)
+            quadrics[indices[i + k]] += quadric;
+    }
+    return quadrics;
+}
+
+/// For each vertex, the list of triangles (i.e. index of their first index) that use it.
+struct Adjacency {
+    std::vector<uint32_t> offsets{};
+    std::vector<uint32_t> triangles{};
+
+    Adjacency(size_t vertices_count, std::span<uint32_t const> indices)
+        : offsets(vertices_count + 1, 0)
+        , triangles(indices.size())
+    {
+        for (auto const index : indices)
+            offsets[index + 1]++;
+        for (size_t vertex = 0; vertex < vertices_count; ++vertex)
+            offsets[vertex + 1] += offsets[vertex];
+        auto fill = std::vector<uint32_t>(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            triangles[fill[indices[i]]++] = static_cast<uint32_t>(i - i % 3);
+    }
+
+    auto of(uint32_t vertex) const -> std::span<uint32_t const>
+    {
+        return std::span{triangles}.subspan(offsets[vertex], offsets[vertex + 1] - offsets[vertex]);
+    }
+};
+
+/// Checks that moving `from` onto `to` doesn't flip any of the triangles around `from`.
+auto collapse_flips_a_triangle(uint32_t from, uint32_t to, std::vector<glm::vec3> const& positions, std::span<uint32_t const> indices, Adjacency const& adjacency) -> bool
+{
+    for (auto const first_index : adjacency.of(from))
+    {
+        auto const triangle = indices.subspan(first_index, 3);
+        if (std::find(triangle.begin(), triangle.end(), to) != triangle.end())
+            continue; // This triangle is going to disappear anyways
+
+        auto const position_after = [&](uint32_t vertex) { return vertex == from ? positions[to] : positions[vertex]; };
+        auto const normal_before  = glm::cross(positions[triangle[1]] - positions[triangle[0]], positions[triangle[2]] - positions[triangle[0]]);
+        auto const normal_after   = glm::cross(position_after(triangle[1]) - position_after(triangle[0]), position_after(triangle[2]) - position_after(triangle[0]));
+        if (glm::dot(normal_before, normal_after) <= 0.f)
+            return true;
+    }
+    return false;
+}
+
+struct Collapse {
+    uint32_t from{};
+    uint32_t to{};
+    double   error{}; // Squared distance
+};
+
+} // namespace
+
+auto simplify_mesh(MeshData const& data, std::span<uint32_t const> indices, size_t target_indices_count, float max_error) -> SimplifyMesh_Result
+{
+    assert(indices.size() % 3 == 0);
+
+    auto positions = std::vector<glm::vec3>(data.vertices_count());
+    for (size_t vertex = 0; vertex < positions.size(); ++vertex)
+        positions[vertex] = data.position(vertex);
+
+    auto const is_locked = find_locked_vertices(positions, indices);
+    auto       quadrics  = compute_quadrics(positions, indices);
+
+    auto result    = SimplifyMesh_Result{.indices = std::vector<uint32_t>(indices.begin(), indices.end())};
+    auto remap     = std::vector<uint32_t>(positions.size());
+    auto collapses = std::vector<Collapse>{};
+    auto touched   = std::vector<bool>(positions.size());
+
+    // Each pass collapses as many independent edges as possible, and then rebuilds the index buffer
+    while (result.indices.size() > target_indices_count)
+    {
+        auto const adjacency = Adjacency{positions.size(), result.indices};
+
+        collapses.clear();
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+            {
+                auto const a = result.indices[i + k];
+                auto const b = result.indices[i + (k + 1) % 3];
+                for (auto const& [from, to] : {std::pair{a, b}, std::pair{b, a}})
+                {
+                    if (is_locked[from])
+                        continue;
+                    auto quadric = quadrics[from];
+                    quadric += quadrics[to];
+                    collapses.push_back({.from = from, .to = to, .error = quadric.error(glm::dvec3{positions[to]})});
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](Collapse const& a, Collapse const& b) {
+            return a.error < b.error;
+        });
+
+        std::iota(remap.begin(), remap.end(), 0);
+        std::fill(touched.begin(), touched.end(), false);
+        auto const triangles_to_remove = (result.indices.size() - target_indices_count + 2) / 3;
+        size_t     triangles_removed   = 0;
+        size_t     collapses_count     = 0;
+        for (auto const& collapse : collapses)
+        {
+            if (triangles_removed >= triangles_to_remove || std::sqrt(collapse.error) > max_error)
+                break;
+            if (touched[collapse.from] || touched[collapse.to]) // One of the triangles around these vertices has changed during this pass, so the collapse needs to be re-evaluated
+                continue;
+            if (collapse_flips_a_triangle(collapse.from, collapse.to, positions, result.indices, adjacency))
+                continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to] += quadrics[collapse.from];
+            result.error = std::max(result.error, static_cast<float>(std::sqrt(collapse.error)));
+            collapses_count++;
+            for (auto const first_index : adjacency.of(collapse.from))
+            {
+                auto const triangle = std::span{result.indices}.subspan(first_index, 3);
+                if (std::find(triangle.begin(), triangle.end(), collapse.to) != triangle.end())
+                    triangles_removed++;
+                for (auto const vertex : triangle)
+                    touched[vertex] = true;
+            }
+        }
+        if (collapses_count == 0)
+            break;
+
+        // Rebuild the index buffer, without the triangles that have become degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.indices.size(); i += 3)
+        {
+            auto const a = remap[result.indices[i + 0]];
+            auto const b = remap[result.indices[i + 1]];
+            auto const c = remap[result.indices[i + 2]];
+            if (a == b || b == c || c == a)
+                continue;
+            result.indices[write++] = a;
+            result.indices[write++] = b;
+            result.indices[write++] = c;
+        }
+        result.indices.resize(write);
+    }
+
+    return result;
+}
+
+} // namespace gl
@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+#include "MeshData.hpp"
+
+namespace gl {
+
+struct SimplifyMesh_Result {
+    std::vector<uint32_t> indices{};
+    /// Distance between the simplified surface and the original one, in the same unit as the positions of the mesh.
+    float error{};
+};
+
+/// Removes triangles by collapsing edges, starting with the ones that change the shape of the mesh the least (according to Garland and Heckbert's quadric error metric).
+/// Only the index buffer is simplified: the vertices are not moved, so the result can be used with the same vertex buffer as the original mesh.
+/// Vertices on the borders of the mesh, and on the seams between UV islands or hard edges, are never removed so that no hole appears in the mesh.
+/// Stops as soon as `target_indices_count` is reached, or when the error would exceed `max_error`.
+/// `indices` can be a subset of data.indices (e.g. a previous LOD), and the vertices of `data` must start with a Position3D.
+auto simplify_mesh(MeshData const& data, std::span<uint32_t const> indices, size_t target_indices_count, float max_error = std::numeric_limits<float>::max()) -> SimplifyMesh_Result;
+
+} // namespace gl
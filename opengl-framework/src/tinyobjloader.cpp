@@ -1,2 +1,8 @@
 #define TINYOBJLOADER_IMPLEMENTATION
 #include "tiny_obj_loader.h"
+
+#if defined(_WIN32) && !defined(NOMINMAX)
+#define NOMINMAX // tinyobj_loader_opt.h includes windows.h
+#endif
+#define TINYOBJ_LOADER_OPT_IMPLEMENTATION
+#include "tinyobj_loader_opt.h"
@@ -0,0 +1,51 @@
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <vector>
+#include "opengl-framework/opengl-framework.hpp"
+
+// Runs a compute shader over a StorageBuffer and checks its results on the CPU.
+// Exits with a non-zero code if they are wrong, so it can be run on a headless driver (e.g. Mesa's llvmpipe) to test the compute path.
+
+int main()
+{
+    gl::init("Compute test");
+
+    auto const compute = gl::ComputeShader{{
+        .compute = gl::ShaderSource::Code{R"glsl(
+#version 430
+layout(local_size_x = 64) in;
+layout(std430, binding = 0) buffer Values {
+    float values[];
+};
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(values.length())) // The last work group has some extra invocations
+        return;
+    values[i] = 2. * values[i] + 1.;
+}
+)glsl"},
+    }};
+
+    constexpr size_t elements_count = 1000; // Not a multiple of the work group size, to check that the extra invocations are ignored
+    auto             input          = std::vector<float>(elements_count);
+    std::iota(input.begin(), input.end(), 0.f);
+    auto buffer = gl::StorageBuffer<float>{input};
+
+    buffer.bind(0);
+    compute.dispatch_for({elements_count, 1, 1});
+    gl::memory_barrier(gl::Barrier::Readback);
+    auto const output = buffer.download();
+
+    for (size_t i = 0; i < elements_count; ++i)
+    {
+        if (output[i] != 2.f * input[i] + 1.f)
+        {
+            std::cerr << "Wrong value at index " << i << ": expected " << 2.f * input[i] + 1.f << ", got " << output[i] << '\n';
+            return EXIT_FAILURE;
+        }
+    }
+    std::cout << "The compute shader processed the " << elements_count << " elements correctly.\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+#include <chrono>
+#include <iostream>
+#include "opengl-framework/opengl-framework.hpp"
+
+// Compares the CPU cost of the different ways of setting a uniform.
+// Run it in Release, otherwise the debug checks dominate the timings.
+
+namespace {
+
+constexpr int iterations_count = 1'000'000;
+
+template<typename Callback>
+void benchmark(std::string_view name, Callback&& callback)
+{
+    glFinish();
+    auto const begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations_count; ++i)
+        callback(i);
+    auto const end      = std::chrono::steady_clock::now();
+    auto const duration = std::chrono::duration<double, std::nano>{end - begin};
+    std::cout << name << ": " << duration.count() / iterations_count << " ns/call\n";
+}
+
+} // namespace
+
+int main()
+{
+    gl::init("Uniform benchmark");
+
+    auto const shader = gl::Shader{{
+        .vertex   = gl::ShaderSource::Code{R"glsl(
+#version 410
+layout(location = 0) in vec3 in_position;
+uniform mat4 view_projection_matrix;
+uniform vec4 offsets[4];
+void main()
+{
+    gl_Position = view_projection_matrix * vec4(in_position + offsets[gl_VertexID % 4].xyz, 1.);
+}
+)glsl"},
+        .fragment = gl::ShaderSource::Code{R"glsl(
+#version 410
+out vec4 out_color;
+uniform float time;
+void main()
+{
+    out_color = vec4(time);
+}
+)glsl"},
+    }};
+    shader.bind();
+
+    auto const time_handle = shader.uniform_handle("time");
+
+    benchmark("glGetUniformLocation() + glUniform1f()", [&](int i) {
+        glUniform1f(glGetUniformLocation(shader.id(), "time"), static_cast<float>(i));
+    });
+    benchmark("set_uniform(std::string_view)        ", [&](int i) {
+        shader.set_uniform("time", static_cast<float>(i));
+    });
+    benchmark("set_uniform(UniformHandle)           ", [&](int i) {
+        shader.set_uniform(time_handle, static_cast<float>(i));
+    });
+    benchmark("glUniform1f() (baseline)             ", [&](int i) {
+        glUniform1f(time_handle.location(), static_cast<float>(i));
+    });
+}
@@ -1,9 +1,10 @@
 #version 410
 
 out vec4 FragColor;
-uniform vec3 light_direction;
 in vec3 normals;
 
+#include "uniform_blocks.glsl"
+
 uniform sampler2D myTexture;
 
 void main()
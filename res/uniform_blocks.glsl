@@ -0,0 +1,19 @@
+// Filled by gl::set_frame_uniforms() and gl::set_object_uniforms()
+// The declarations must be the same in all the stages, so they all include this file.
+
+layout(std140) uniform FrameUniforms {
+    mat4  view;
+    mat4  projection;
+    mat4  view_projection;
+    vec4  camera_position;
+    vec4  light_direction;
+    vec4  light_color;
+    float time;
+    float delta_time;
+    vec2  framebuffer_size;
+} frame;
+
+layout(std140) uniform ObjectUniforms {
+    mat4 transform;
+    mat4 normal_matrix;
+} object;
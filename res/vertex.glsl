@@ -7,12 +7,11 @@ layout(location = 2) in vec3 in_normals;
 out vec2 TexCoord;
 out vec3 normals;
 
-uniform mat4 _view_projection;
-uniform mat4 _transform;
+#include "uniform_blocks.glsl"
 
 void main()
 {
-    gl_Position = _view_projection * _transform * vec4(aPos, 1.0);
+    gl_Position = frame.view_projection * object.transform * vec4(aPos, 1.0);
     TexCoord = aTexCoord;
-    normals = in_normals;
+    normals = mat3(object.normal_matrix) * in_normals;
 }
\ No newline at end of file
@@ -2,49 +2,15 @@
 #include <glm/ext/matrix_clip_space.hpp>
 #include <iostream>
 #include <glm/ext/matrix_transform.hpp>
-#include "tiny_obj_loader.h"
-
-
-auto load_mesh(std::filesystem::path const& path) -> gl::Mesh
-{
-    // On lit le fichier avec tinyobj
-    auto reader = tinyobj::ObjReader{};
-    reader.ParseFromFile(gl::make_absolute_path(path).string(), {});
-
-    // On met tous les attributs dans un tableau
-    auto vertices = std::vector<float>{};
-    for (auto const& shape : reader.GetShapes())
-    {
-        for (auto const& idx : shape.mesh.indices)
-        {
-            vertices.push_back(reader.GetAttrib().vertices[3 * idx.vertex_index + 0]);
-            vertices.push_back(reader.GetAttrib().vertices[3 * idx.vertex_index + 1]);
-            vertices.push_back(reader.GetAttrib().vertices[3 * idx.vertex_index + 2]);
-
-            vertices.push_back(reader.GetAttrib().texcoords[2 * idx.texcoord_index + 0]);
-            vertices.push_back(reader.GetAttrib().texcoords[2 * idx.texcoord_index + 1]);
-
-            vertices.push_back(reader.GetAttrib().normals[3 * idx.normal_index + 0]);
-            vertices.push_back(reader.GetAttrib().normals[3 * idx.normal_index + 1]);
-            vertices.push_back(reader.GetAttrib().normals[3 * idx.normal_index + 2]);
-        };
-    }
-    return gl::Mesh{ {
-    .vertex_buffers = {{
-        .layout = {gl::VertexAttribute::Position3D{0}, gl::VertexAttribute::UV{1} ,gl::VertexAttribute::Normal3D{2}},
-        .data = vertices
-    }}
-} };
-}
 
 int main()
 {
     // Initialisation
     gl::init("TPs de Rendering");
     gl::maximize_window();
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_ONE);
-    glEnable(GL_DEPTH_TEST);
+    gl::StateCache::set_enabled(GL_BLEND, true);
+    gl::StateCache::set_blend_function(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE_MINUS_DST_ALPHA, GL_ONE);
+    gl::StateCache::set_enabled(GL_DEPTH_TEST, true);
 
     auto camera = gl::Camera{};
     gl::set_events_callbacks({
@@ -103,21 +69,35 @@ int main()
         }
     };
 
+    auto mesh_cache = gl::MeshCache{};
+
     while (gl::window_is_open())
     {
         glClearColor(0.f, 0.f, 1.f, 1.f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        auto const projection = glm::infinitePerspective(glm::radians(45.f), gl::framebuffer_aspect_ratio(), 0.1f);
+        gl::set_frame_uniforms({
+            .view = camera.view_matrix(),
+            .projection = projection,
+            .view_projection = projection * camera.view_matrix(),
+            .camera_position = glm::vec4{ camera.position(), 1.f },
+            .light_direction = glm::vec4{ 0.2f, 0.3f, -1.f, 0.f },
+            .time = gl::time_in_seconds(),
+            .delta_time = gl::delta_time_in_seconds(),
+            .framebuffer_size = glm::vec2{ gl::framebuffer_width_in_pixels(), gl::framebuffer_height_in_pixels() },
+        });
+
         shader.bind();
-        shader.set_uniform("_view_projection", glm::infinitePerspective(glm::radians(45.f), gl::framebuffer_aspect_ratio(), 0.1f) * camera.view_matrix());
-        shader.set_uniform("_transform", glm::translate(glm::rotate(glm::mat4{ 1.f }, gl::time_in_seconds(), glm::vec3{ 0.f, 0.f, 1.f }), glm::vec3{ 0.f, 1.f, 0.f }));
-        shader.set_uniform("light_direction", glm::vec3(0.2, 0.3, -1));
         shader.set_uniform("myTexture", texture);
 
+        auto const transform = glm::translate(glm::rotate(glm::mat4{ 1.f }, gl::time_in_seconds(), glm::vec3{ 0.f, 0.f, 1.f }), glm::vec3{ 0.f, 1.f, 0.f });
+        gl::set_object_uniforms({ .transform = transform, .normal_matrix = glm::inverse(glm::transpose(transform)) });
+
         //cube_mesh.draw();
 
-        auto const boat = load_mesh("res/fourareen.obj");
-        boat.draw();
+        auto const boat = mesh_cache.get("res/fourareen.obj");
+        boat->draw();
     }
 
     return 0;